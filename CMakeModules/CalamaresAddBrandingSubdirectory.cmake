@@ -53,6 +53,11 @@ include( CMakeColors )
 #
 # If SUBDIRECTORIES are given, then those are copied (each one level deep)
 # to the installation location as well, preserving the subdirectory name.
+#
+# If WITH_QMLCACHEGEN is set (and qmlcachegen can be found), each QML
+# file is also compiled ahead-of-time into a .qmlc file, which is
+# installed next to the QML file. The QML engine picks up the .qmlc
+# instead of compiling the QML (e.g. the slideshow) at runtime.
 function( calamares_add_branding NAME )
     cmake_parse_arguments( _CABT "" "DIRECTORY" "SUBDIRECTORIES" ${ARGN} )
     if (NOT _CABT_DIRECTORY)
@@ -65,6 +70,11 @@ function( calamares_add_branding NAME )
     set( BRANDING_DIR share/calamares/branding )
     set( BRANDING_COMPONENT_DESTINATION ${BRANDING_DIR}/${NAME} )
 
+    set( _qmlc_files "" )
+    if( WITH_QMLCACHEGEN )
+        find_program( QMLCACHEGEN_EXECUTABLE qmlcachegen HINTS "${_qt5Core_install_prefix}/bin" )
+    endif()
+
     foreach( _subdir "" ${_CABT_SUBDIRECTORIES} )
         file( GLOB BRANDING_COMPONENT_FILES RELATIVE ${CMAKE_CURRENT_SOURCE_DIR}/${_brand_dir} "${_brand_dir}/${_subdir}/*" )
         foreach( BRANDING_COMPONENT_FILE ${BRANDING_COMPONENT_FILES} )
@@ -74,13 +84,31 @@ function( calamares_add_branding NAME )
 
                 install( FILES ${CMAKE_CURRENT_BINARY_DIR}/${_subpath}
                             DESTINATION ${BRANDING_COMPONENT_DESTINATION}/${_subdir}/ )
+
+                if( QMLCACHEGEN_EXECUTABLE AND _subpath MATCHES "[.]qml$" )
+                    add_custom_command(
+                        OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/${_subpath}c
+                        COMMAND ${QMLCACHEGEN_EXECUTABLE} -o ${CMAKE_CURRENT_BINARY_DIR}/${_subpath}c ${CMAKE_CURRENT_BINARY_DIR}/${_subpath}
+                        DEPENDS ${CMAKE_CURRENT_BINARY_DIR}/${_subpath}
+                    )
+                    list( APPEND _qmlc_files ${CMAKE_CURRENT_BINARY_DIR}/${_subpath}c )
+                    install( FILES ${CMAKE_CURRENT_BINARY_DIR}/${_subpath}c
+                                DESTINATION ${BRANDING_COMPONENT_DESTINATION}/${_subdir}/ )
+                endif()
             endif()
         endforeach()
     endforeach()
+    if( _qmlc_files )
+        add_custom_target( branding-qmlc-${NAME} ALL DEPENDS ${_qmlc_files} )
+    endif()
 
     message( "-- ${BoldYellow}Found ${CALAMARES_APPLICATION_NAME} branding component: ${BoldRed}${NAME}${ColorReset}" )
     message( "   ${Green}TYPE:${ColorReset} branding component" )
     message( "   ${Green}BRANDING_COMPONENT_DESTINATION:${ColorReset} ${BRANDING_COMPONENT_DESTINATION}" )
+    if( _qmlc_files )
+        list( LENGTH _qmlc_files _qmlc_count )
+        message( "   ${Green}BRANDING_QML_CACHE:${ColorReset} ${_qmlc_count} file(s)" )
+    endif()
 endfunction()
 
 # Usage calamares_add_branding_translations( <name> [DIRECTORY <dir>])
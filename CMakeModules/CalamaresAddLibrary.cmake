@@ -63,7 +63,14 @@ function(calamares_add_library)
 
     # add resources from current dir
     if(EXISTS "${CMAKE_CURRENT_LIST_DIR}/${LIBRARY_RESOURCES}")
-        qt5_add_resources(LIBRARY_RC_SOURCES "${LIBRARY_RESOURCES}")
+        # With the Qt Quick Compiler, QML files listed in the resource
+        # are compiled ahead-of-time, so they need not be compiled
+        # when the module's page is first loaded.
+        if(WITH_QMLCACHEGEN)
+            qtquick_compiler_add_resources(LIBRARY_RC_SOURCES "${LIBRARY_RESOURCES}")
+        else()
+            qt5_add_resources(LIBRARY_RC_SOURCES "${LIBRARY_RESOURCES}")
+        endif()
         list(APPEND LIBRARY_SOURCES ${LIBRARY_RC_SOURCES})
         unset(LIBRARY_RC_SOURCES)
     endif()
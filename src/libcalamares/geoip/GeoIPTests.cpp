@@ -194,6 +194,53 @@ GeoIPTests::testSplitTZ()
     QCOMPARE( tz.second, QStringLiteral( "North_Dakota/Beulah" ) );
 }
 
+void
+GeoIPTests::testHandlerConfig()
+{
+    // Single provider, old-style
+    {
+        Handler h( QVariantMap { { "style", "json" }, { "url", "http://example.com/" }, { "timeout", 3 } } );
+        QVERIFY( h.isValid() );
+        QCOMPARE( h.providers().count(), 1 );
+        QCOMPARE( h.type(), Handler::Type::JSON );
+        QCOMPARE( h.url(), QStringLiteral( "http://example.com/" ) );
+        QCOMPARE( h.providers().first().timeout, std::chrono::milliseconds( 3000 ) );
+    }
+    // Disabled
+    {
+        Handler h( QVariantMap { { "style", "none" }, { "url", "http://example.com/" } } );
+        QVERIFY( !h.isValid() );
+        QCOMPARE( h.type(), Handler::Type::None );
+    }
+    // Several providers, bad ones are skipped, timeout is inherited
+    {
+        QVariantList providers {
+            QVariantMap { { "style", "json" }, { "url", "http://one.example.com/" } },
+            QVariantMap { { "style", "bogus" }, { "url", "http://two.example.com/" } },
+            QVariantMap { { "style", "json" }, { "url", "http://three.example.com/" }, { "timeout", 1 } },
+        };
+        Handler h( QVariantMap { { "style", "none" }, { "timeout", 5 }, { "providers", providers } } );
+        QVERIFY( h.isValid() );
+        QCOMPARE( h.providers().count(), 2 );
+        QCOMPARE( h.url(), QStringLiteral( "http://one.example.com/" ) );
+        QCOMPARE( h.providers().at( 0 ).timeout, std::chrono::milliseconds( 5000 ) );
+        QCOMPARE( h.providers().at( 1 ).url, QStringLiteral( "http://three.example.com/" ) );
+        QCOMPARE( h.providers().at( 1 ).timeout, std::chrono::milliseconds( 1000 ) );
+    }
+    // Without a timeout, providers still give up eventually
+    {
+        Handler single( QVariantMap { { "style", "json" }, { "url", "http://example.com/" } } );
+        QCOMPARE( single.providers().first().timeout, Handler::defaultTimeout );
+
+        QVariantList providers { QVariantMap { { "style", "json" }, { "url", "http://one.example.com/" } } };
+        Handler several( QVariantMap { { "providers", providers } } );
+        QCOMPARE( several.providers().count(), 1 );
+        QCOMPARE( several.providers().first().timeout, Handler::defaultTimeout );
+
+        QVERIFY( Handler::defaultTimeout.count() > 0 );
+    }
+}
+
 
 #define CHECK_GET( t, selector, url ) \
     { \
@@ -38,6 +38,7 @@ private Q_SLOTS:
     void testXMLalt();
     void testXMLbad();
     void testSplitTZ();
+    void testHandlerConfig();
 
     void testGet();
 };
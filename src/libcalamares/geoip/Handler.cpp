@@ -28,6 +28,9 @@
 #include "utils/NamedEnum.h"
 #include "utils/Variant.h"
 
+#include <QEventLoop>
+#include <QNetworkReply>
+
 #include <memory>
 
 static const NamedEnumTable< CalamaresUtils::GeoIP::Handler::Type >&
@@ -53,33 +56,89 @@ namespace CalamaresUtils
 namespace GeoIP
 {
 
-Handler::Handler()
-    : m_type( Type::None )
-{
-}
-
-Handler::Handler( const QString& implementation, const QString& url, const QString& selector )
-    : m_type( Type::None )
-    , m_url( url )
-    , m_selector( selector )
+/** @brief Look up the type for @p implementation
+ *
+ * Logs a warning and returns None for types that are not known, or not
+ * supported in this build of Calamares.
+ */
+static Handler::Type
+handlerType( const QString& implementation )
 {
     bool ok = false;
-    m_type = handlerTypes().find( implementation, ok );
+    Handler::Type t = handlerTypes().find( implementation, ok );
     if ( !ok )
     {
         cWarning() << "GeoIP style" << implementation << "is not recognized.";
+        return Handler::Type::None;
     }
-    else if ( m_type == Type::None )
+    else if ( t == Handler::Type::None )
     {
         cWarning() << "GeoIP style *none* does not do anything.";
     }
 #if !defined( QT_XML_LIB )
-    else if ( m_type == Type::XML )
+    else if ( t == Handler::Type::XML )
     {
-        m_type = Type::None;
         cWarning() << "GeoIP style *xml* is not supported in this version of Calamares.";
+        return Handler::Type::None;
     }
 #endif
+    return t;
+}
+
+/// @brief Reads a provider from the keys *style*, *url*, *selector* and *timeout* of @p map
+static Handler::Provider
+providerFromMap( const QVariantMap& map, std::chrono::milliseconds defaultTimeout )
+{
+    Handler::Provider p;
+    p.type = handlerType( CalamaresUtils::getString( map, "style" ) );
+    p.url = CalamaresUtils::getString( map, "url" );
+    p.selector = CalamaresUtils::getString( map, "selector" );
+
+    qint64 timeout = CalamaresUtils::getInteger( map, "timeout", -1 );
+    p.timeout = timeout > 0 ? std::chrono::milliseconds( timeout * 1000 ) : defaultTimeout;
+    return p;
+}
+
+constexpr std::chrono::milliseconds Handler::defaultTimeout;
+
+Handler::Handler() {}
+
+Handler::Handler( const QString& implementation, const QString& url, const QString& selector )
+{
+    Provider p;
+    p.type = handlerType( implementation );
+    p.url = url;
+    p.selector = selector;
+    if ( p.type != Type::None )
+    {
+        m_providers.append( p );
+    }
+}
+
+Handler::Handler( const QVariantMap& configuration )
+{
+    const QVariantList providers = configuration.value( QStringLiteral( "providers" ) ).toList();
+    if ( providers.isEmpty() )
+    {
+        const Provider p = providerFromMap( configuration, defaultTimeout );
+        if ( p.type != Type::None )
+        {
+            m_providers.append( p );
+        }
+        return;
+    }
+
+    const qint64 timeout = CalamaresUtils::getInteger( configuration, "timeout", -1 );
+    const std::chrono::milliseconds providerTimeout
+        = timeout > 0 ? std::chrono::milliseconds( timeout * 1000 ) : defaultTimeout;
+    for ( const auto& v : providers )
+    {
+        Provider p = providerFromMap( v.toMap(), providerTimeout );
+        if ( p.type != Type::None )
+        {
+            m_providers.append( p );
+        }
+    }
 }
 
 Handler::~Handler() {}
@@ -103,28 +162,101 @@ create_interface( Handler::Type t, const QString& selector )
     NOTREACHED return nullptr;
 }
 
-static RegionZonePair
-do_query( Handler::Type type, const QString& url, const QString& selector )
+static inline bool
+isAcceptable( const RegionZonePair& r )
 {
-    const auto interface = create_interface( type, selector );
-    if ( !interface )
-    {
-        return RegionZonePair();
-    }
+    return r.isValid();
+}
 
-    return interface->processReply( CalamaresUtils::Network::Manager::instance().synchronousGet( url ) );
+static inline bool
+isAcceptable( const QString& s )
+{
+    return !s.isEmpty();
 }
 
-static QString
-do_raw_query( Handler::Type type, const QString& url, const QString& selector )
+/** @brief Queries all the @p providers in parallel
+ *
+ * The data from each successful reply is passed to @p interpret
+ * (along with the Interface for that provider). The first acceptable
+ * interpretation is returned, and the remaining requests are aborted.
+ * If no reply is acceptable, returns a default-constructed T.
+ *
+ * Like synchronousGet(), this runs a local event loop, so it is
+ * meant to be called from a worker thread (e.g. from query()).
+ */
+template < typename T, typename F >
+static T
+do_parallel_query( const QVector< Handler::Provider >& providers, F interpret )
 {
-    const auto interface = create_interface( type, selector );
-    if ( !interface )
+    auto& network = CalamaresUtils::Network::Manager::instance();
+
+    QEventLoop loop;
+    QVector< QNetworkReply* > replies;
+    int pending = 0;
+    T result;
+
+    for ( const auto& provider : providers )
     {
-        return QString();
+        std::shared_ptr< Interface > interface( create_interface( provider.type, provider.selector ) );
+        if ( !interface )
+        {
+            continue;
+        }
+
+        QNetworkReply* reply = network.asynchronousGet(
+            QUrl( provider.url ), Network::RequestOptions( Network::RequestOptions::Flags(), provider.timeout ) );
+        if ( !reply )
+        {
+            cWarning() << "GeoIP lookup at" << provider.url << "failed.";
+            continue;
+        }
+
+        replies.append( reply );
+        ++pending;
+        QObject::connect( reply, &QNetworkReply::finished, &loop, [&, reply, interface, url = provider.url]() {
+            --pending;
+            if ( !isAcceptable( result ) && reply->error() == QNetworkReply::NoError )
+            {
+                T r = interpret( interface.get(), reply->readAll() );
+                if ( isAcceptable( r ) )
+                {
+                    cDebug() << "GeoIP result from" << url;
+                    result = r;
+                }
+            }
+            if ( isAcceptable( result ) || !pending )
+            {
+                loop.quit();
+            }
+        } );
     }
 
-    return interface->rawReply( CalamaresUtils::Network::Manager::instance().synchronousGet( url ) );
+    if ( pending )
+    {
+        loop.exec();
+    }
+
+    for ( auto* reply : replies )
+    {
+        reply->disconnect( &loop );
+        reply->abort();
+        delete reply;
+    }
+    return result;
+}
+
+static RegionZonePair
+do_query( const QVector< Handler::Provider >& providers )
+{
+    return do_parallel_query< RegionZonePair >(
+        providers, []( Interface* i, const QByteArray& data ) { return i->processReply( data ); } );
+}
+
+static QString
+do_raw_query( const QVector< Handler::Provider >& providers )
+{
+    return do_parallel_query< QString >( providers,
+                                         []( Interface* i, const QByteArray& data ) { return i->rawReply( data ); } );
 }
 
 RegionZonePair
@@ -134,18 +266,16 @@ Handler::get() const
     {
         return RegionZonePair();
     }
-    return do_query( m_type, m_url, m_selector );
+    return do_query( m_providers );
 }
 
 
 QFuture< RegionZonePair >
 Handler::query() const
 {
-    Handler::Type type = m_type;
-    QString url = m_url;
-    QString selector = m_selector;
+    auto providers = m_providers;
 
-    return QtConcurrent::run( [=] { return do_query( type, url, selector ); } );
+    return QtConcurrent::run( [=] { return do_query( providers ); } );
 }
 
 QString
@@ -155,18 +285,16 @@ Handler::getRaw() const
     {
         return QString();
     }
-    return do_raw_query( m_type, m_url, m_selector );
+    return do_raw_query( m_providers );
 }
 
 
 QFuture< QString >
 Handler::queryRaw() const
 {
-    Handler::Type type = m_type;
-    QString url = m_url;
-    QString selector = m_selector;
+    auto providers = m_providers;
 
-    return QtConcurrent::run( [=] { return do_raw_query( type, url, selector ); } );
+    return QtConcurrent::run( [=] { return do_raw_query( providers ); } );
 }
 
 }  // namespace GeoIP
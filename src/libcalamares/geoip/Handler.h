@@ -23,8 +23,11 @@
 
 #include <QString>
 #include <QVariantMap>
+#include <QVector>
 #include <QtConcurrent/QtConcurrentRun>
 
+#include <chrono>
+
 namespace CalamaresUtils
 {
 namespace GeoIP
@@ -37,6 +40,16 @@ namespace GeoIP
  * synchronous API and will return an invalid zone pair on
  * error or if the configuration is not understood. For an
  * async API, use query().
+ *
+ * A handler may have more than one provider. All of the providers
+ * are queried in parallel, and the first reply that can be
+ * interpreted is used; the remaining requests are cancelled.
+ *
+ * Each provider has a timeout (defaultTimeout, unless configured),
+ * so a provider that never answers can't hold up the lookup (or
+ * whatever waits for it, like the requirements checks of the locale
+ * modules). That is also why there is no need to ping a provider
+ * before querying it.
  */
 class DLLEXPORT Handler
 {
@@ -48,6 +61,18 @@ public:
         XML
     };
 
+    /// @brief The timeout of a provider that doesn't configure one
+    static constexpr std::chrono::milliseconds defaultTimeout = std::chrono::seconds( 10 );
+
+    /// @brief One GeoIP source: the style of data, where to get it, what to select
+    struct Provider
+    {
+        Type type = Type::None;
+        QString url;
+        QString selector;
+        std::chrono::milliseconds timeout = defaultTimeout;
+    };
+
     /** @brief An unconfigured handler; this always returns errors. */
     Handler();
     /** @brief A handler for a specific GeoIP source.
@@ -57,6 +82,16 @@ public:
      * is used to select something from the data returned by the @url.
      */
     Handler( const QString& implementation, const QString& url, const QString& selector );
+    /** @brief A handler configured from a *geoip* configuration map.
+     *
+     * The map may contain the keys *style*, *url*, *selector* and
+     * *timeout* (in seconds) for a single provider, or a list of
+     * maps with those keys, under *providers*, for several providers.
+     * With *providers*, only the *timeout* is read from the map itself,
+     * as the default for the providers. Providers with an unrecognized
+     * style are ignored.
+     */
+    explicit Handler( const QVariantMap& configuration );
 
     ~Handler();
 
@@ -78,15 +113,19 @@ public:
     /// @brief Like query, but don't interpret the contents
     QFuture< QString > queryRaw() const;
 
-    bool isValid() const { return m_type != Type::None; }
-    Type type() const { return m_type; }
-    QString url() const { return m_url; }
-    QString selector() const { return m_selector; }
+    bool isValid() const { return !m_providers.isEmpty(); }
+    /// @brief The type of the first provider
+    Type type() const { return isValid() ? m_providers.first().type : Type::None; }
+    /// @brief The URL of the first provider
+    QString url() const { return isValid() ? m_providers.first().url : QString(); }
+    /// @brief The selector of the first provider
+    QString selector() const { return isValid() ? m_providers.first().selector : QString(); }
+
+    /// @brief All the (valid) providers of this handler
+    const QVector< Provider >& providers() const { return m_providers; }
 
 private:
-    Type m_type;
-    const QString m_url;
-    const QString m_selector;
+    QVector< Provider > m_providers;
 };
 
 }  // namespace GeoIP
@@ -0,0 +1,175 @@
+/* === This file is part of Calamares - <https://github.com/calamares> ===
+ *
+ *   Copyright 2020, agent <agent@local>
+ *
+ *   Calamares is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Calamares is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Calamares. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AvailableLocales.h"
+
+#include "utils/Logger.h"
+
+#include <QFile>
+#include <QFuture>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QProcess>
+#include <QtConcurrent/QtConcurrentRun>
+
+static const char SUPPORTED_LOCALES[] = "/usr/share/i18n/SUPPORTED";
+
+namespace CalamaresUtils
+{
+namespace Locale
+{
+namespace AvailableLocales
+{
+
+QStringList
+fromData( const QByteArray& data, bool commented )
+{
+    QStringList locales;
+    for ( const QByteArray& rawLine : data.split( '\n' ) )
+    {
+        QByteArray line = rawLine.simplified();
+        if ( commented )
+        {
+            // Explanatory comments in locale.gen start with "# " or "## ",
+            // while commented-out locales have no space after the #.
+            if ( line.startsWith( "## " ) || line.startsWith( "# " ) || line == "#" )
+            {
+                continue;
+            }
+            if ( line.startsWith( '#' ) )
+            {
+                line = line.replace( '#', QByteArray() ).simplified();
+            }
+        }
+        if ( line.isEmpty() )
+        {
+            continue;
+        }
+
+        // We usually only want UTF-8 locales, because it's not 1995.
+        const QByteArray lower = line.toLower();
+        if ( !lower.contains( "utf-8" ) && !lower.contains( "utf8" ) )
+        {
+            continue;
+        }
+        // We strip " UTF-8" from "en_US.UTF-8 UTF-8" because it's redundant redundant.
+        if ( line.endsWith( " UTF-8" ) )
+        {
+            line.chop( 6 );
+        }
+        locales.append( QString::fromLatin1( line.simplified() ) );
+    }
+    return locales;
+}
+
+static QStringList
+discover( const QString& localeGenPath )
+{
+    // Some distros come with a meaningfully commented and easy to parse locale.gen,
+    // and others ship a separate file /usr/share/i18n/SUPPORTED with a clean list of
+    // supported locales. We first try that one, and if it doesn't exist, we fall back
+    // to parsing the lines from locale.gen
+    QStringList locales;
+    QFile supported( SUPPORTED_LOCALES );
+    if ( supported.exists() && supported.open( QIODevice::ReadOnly | QIODevice::Text ) )
+    {
+        locales = fromData( supported.readAll(), false );
+    }
+    else
+    {
+        QByteArray ba;
+        QFile localeGen( localeGenPath );
+        if ( localeGen.open( QIODevice::ReadOnly | QIODevice::Text ) )
+        {
+            ba = localeGen.readAll();
+        }
+        else
+        {
+            cWarning() << "Cannot open file" << localeGenPath
+                       << ". Assuming the supported languages are already built into "
+                          "the locale archive.";
+            QProcess localeA;
+            localeA.start( "locale", QStringList() << "-a" );
+            localeA.waitForFinished();
+            ba = localeA.readAllStandardOutput();
+        }
+        locales = fromData( ba, true );
+    }
+
+    if ( locales.isEmpty() )
+    {
+        cWarning() << "cannot acquire a list of available locales."
+                   << "The locale and localecfg modules will be broken as long as this "
+                      "system does not provide"
+                   << "\n\t  "
+                   << "* a well-formed" << supported.fileName() << "\n\tOR"
+                   << "* a well-formed"
+                   << ( localeGenPath.isEmpty() ? QLatin1String( "/etc/locale.gen" ) : localeGenPath ) << "\n\tOR"
+                   << "* a complete pre-compiled locale-gen database which allows complete locale -a output.";
+    }
+    else
+    {
+        cDebug() << "Found" << locales.count() << "available locales.";
+    }
+    return locales;
+}
+
+static QMutex&
+discoveryMutex()
+{
+    static QMutex m;
+    return m;
+}
+
+/// @brief Results (or discovery-in-progress) per locale.gen path, for the whole session
+static QHash< QString, QFuture< QStringList > >&
+discoveries()
+{
+    static QHash< QString, QFuture< QStringList > > d;
+    return d;
+}
+
+static QFuture< QStringList >
+discovery( const QString& localeGenPath )
+{
+    QMutexLocker lock( &discoveryMutex() );
+    auto& d = discoveries();
+    auto it = d.find( localeGenPath );
+    if ( it == d.end() )
+    {
+        it = d.insert( localeGenPath, QtConcurrent::run( discover, localeGenPath ) );
+    }
+    return it.value();
+}
+
+void
+start( const QString& localeGenPath )
+{
+    (void)discovery( localeGenPath );
+}
+
+QStringList
+get( const QString& localeGenPath )
+{
+    return discovery( localeGenPath ).result();
+}
+
+}  // namespace AvailableLocales
+}  // namespace Locale
+}  // namespace CalamaresUtils
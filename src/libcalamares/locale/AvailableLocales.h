@@ -0,0 +1,69 @@
+/* === This file is part of Calamares - <https://github.com/calamares> ===
+ *
+ *   Copyright 2020, agent <agent@local>
+ *
+ *   Calamares is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Calamares is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Calamares. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOCALE_AVAILABLELOCALES_H
+#define LOCALE_AVAILABLELOCALES_H
+
+#include "DllMacro.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+namespace CalamaresUtils
+{
+namespace Locale
+{
+/** @brief The (UTF-8) locales that can be selected for the target system
+ *
+ * These come from /usr/share/i18n/SUPPORTED if it exists, otherwise
+ * from the locale.gen file given, and otherwise from `locale -a`.
+ * Finding them is done in a background thread, and only once per
+ * session for each locale.gen path. The results are kept in
+ * libcalamares, so the locale and localeq modules (and their pages)
+ * share them.
+ */
+namespace AvailableLocales
+{
+/** @brief Start looking for the available locales
+ *
+ * This returns immediately. Call it as early as possible (e.g.
+ * when the module is configured), so that the list is ready
+ * when the page is shown. Calling it more than once is harmless.
+ */
+DLLEXPORT void start( const QString& localeGenPath );
+
+/** @brief The available locales, e.g. "en_US.UTF-8"
+ *
+ * Starts looking for them if that hasn't been done yet, and
+ * waits until the list is ready.
+ */
+DLLEXPORT QStringList get( const QString& localeGenPath );
+
+/** @brief Extract the UTF-8 locales from the contents of a file
+ *
+ * The @p data is the contents of SUPPORTED (if @p commented is false)
+ * or of a locale.gen file or the output of `locale -a` (if @p commented
+ * is true, and commented-out locales in locale.gen are included).
+ */
+DLLEXPORT QStringList fromData( const QByteArray& data, bool commented );
+}  // namespace AvailableLocales
+}  // namespace Locale
+}  // namespace CalamaresUtils
+
+#endif
@@ -19,21 +19,35 @@
 
 #include "Label.h"
 
+#include <QObject>
+
 namespace CalamaresUtils
 {
 namespace Locale
 {
 
-Label::Label( QObject* parent )
-    : Label( QString(), LabelFormat::IfNeededWithCountry, parent )
+Label::Label()
+    : Label( QString(), LabelFormat::IfNeededWithCountry )
 {
 }
 
-Label::Label( const QString& locale, LabelFormat format, QObject* parent )
-    : QObject( parent )
-    , m_locale( Label::getLocale( locale ) )
+Label::Label( const QString& locale, LabelFormat format )
+    : m_locale( Label::getLocale( locale ) )
     , m_localeId( locale.isEmpty() ? m_locale.name() : locale )
+    , m_format( format )
+    , m_hasCountry( locale.contains( '_' ) )
+{
+}
+
+void
+Label::makeLabels() const
 {
+    if ( m_hasLabels )
+    {
+        return;
+    }
+    m_hasLabels = true;
+
     QString longFormat = QObject::tr( "%1 (%2)" );
 
     QString languageName = m_locale.nativeLanguageName();
@@ -42,11 +56,11 @@ Label::Label( const QString& locale, LabelFormat format, QObject* parent )
 
     if ( languageName.isEmpty() )
     {
-        languageName = QString( "* %1 (%2)" ).arg( locale, englishName );
+        languageName = QString( "* %1 (%2)" ).arg( m_localeId, englishName );
     }
 
-    bool needsCountryName = ( format == LabelFormat::AlwaysWithCountry )
-        || ( locale.contains( '_' ) && QLocale::countriesForLanguage( m_locale.language() ).count() > 1 );
+    bool needsCountryName = ( m_format == LabelFormat::AlwaysWithCountry )
+        || ( m_hasCountry && QLocale::countriesForLanguage( m_locale.language() ).count() > 1 );
 
     if ( needsCountryName )
     {
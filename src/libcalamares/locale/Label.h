@@ -21,7 +21,6 @@
 #define LOCALE_LABEL_H
 
 #include <QLocale>
-#include <QObject>
 #include <QString>
 
 namespace CalamaresUtils
@@ -35,11 +34,14 @@ namespace Locale
  * Support class to turn locale names (as used by Calamares's
  * translation system) into QLocales, and also into consistent
  * human-readable text labels.
+ *
+ * This is a value type. The human-readable labels are expensive
+ * to compute, so that is only done when they are first asked for.
+ * Because of that, a single Label should not be used from more
+ * than one thread at a time.
  */
-class Label : public QObject
+class Label
 {
-    Q_OBJECT
-
 public:
     /** @brief Formatting option for label -- add (country) to label. */
     enum class LabelFormat
@@ -49,7 +51,7 @@ public:
     };
 
     /** @brief Empty locale. This uses the system-default locale. */
-    Label( QObject* parent = nullptr );
+    Label();
 
     /** @brief Construct from a locale name.
      *
@@ -57,9 +59,7 @@ public:
      * The @p format determines whether the country name is always present
      * in the label (human-readable form) or only if needed for disambiguation.
      */
-    Label( const QString& localeName,
-           LabelFormat format = LabelFormat::IfNeededWithCountry,
-           QObject* parent = nullptr );
+    Label( const QString& localeName, LabelFormat format = LabelFormat::IfNeededWithCountry );
 
 
     /** @brief Define a sorting order.
@@ -76,9 +76,17 @@ public:
     bool isEnglish() const { return m_localeId == QLatin1String( "en_US" ) || m_localeId == QLatin1String( "en" ); }
 
     /** @brief Get the human-readable name for this locale. */
-    QString label() const { return m_label; }
+    QString label() const
+    {
+        makeLabels();
+        return m_label;
+    }
     /** @brief Get the *English* human-readable name for this locale. */
-    QString englishLabel() const { return m_englishLabel; }
+    QString englishLabel() const
+    {
+        makeLabels();
+        return m_englishLabel;
+    }
 
     /** @brief Get the Qt locale. */
     QLocale locale() const { return m_locale; }
@@ -100,10 +108,17 @@ public:
     static QLocale getLocale( const QString& localeName );
 
 protected:
+    /// @brief Fill in m_label and m_englishLabel, if that hasn't been done yet
+    void makeLabels() const;
+
     QLocale m_locale;
     QString m_localeId;  // the locale identifier, e.g. "en_GB"
-    QString m_label;  // the native name of the locale
-    QString m_englishLabel;
+    LabelFormat m_format;
+    bool m_hasCountry;  // the identifier names a country, e.g. "en_GB" but not "en"
+
+    mutable bool m_hasLabels = false;
+    mutable QString m_label;  // the native name of the locale
+    mutable QString m_englishLabel;
 };
 
 }  // namespace Locale
@@ -35,9 +35,23 @@ LabelModel::LabelModel( const QStringList& locales, QObject* parent )
     Q_ASSERT( locales.count() > 0 );
     m_locales.reserve( locales.count() );
 
+    // The (expensive) human-readable labels are only made when they are needed
     for ( const auto& l : locales )
     {
-        m_locales.push_back( new Label( l, Label::LabelFormat::IfNeededWithCountry, this ) );
+        m_locales.append( Label( l, Label::LabelFormat::IfNeededWithCountry ) );
+
+        // Index for find( countryCode ), first one wins
+        const int row = m_locales.count() - 1;
+        const auto& label = m_locales.last();
+        if ( !m_rowForLanguage.contains( int( label.language() ) ) )
+        {
+            m_rowForLanguage.insert( int( label.language() ), row );
+        }
+        const int key = localeKey( label.language(), label.country() );
+        if ( !m_rowForLocale.contains( key ) )
+        {
+            m_rowForLocale.insert( key, row );
+        }
     }
 }
 
@@ -66,9 +80,9 @@ LabelModel::data( const QModelIndex& index, int role ) const
     switch ( role )
     {
     case LabelRole:
-        return locale->label();
+        return locale.label();
     case EnglishLabelRole:
-        return locale->englishLabel();
+        return locale.englishLabel();
     default:
         return QVariant();
     }
@@ -86,13 +100,13 @@ LabelModel::locale( int row ) const
     if ( ( row < 0 ) || ( row >= m_locales.count() ) )
     {
         for ( const auto& l : m_locales )
-            if ( l->isEnglish() )
+            if ( l.isEnglish() )
             {
-                return *l;
+                return l;
             }
-        return *m_locales[ 0 ];
+        return m_locales[ 0 ];
     }
-    return *m_locales[ row ];
+    return m_locales[ row ];
 }
 
 int
@@ -100,7 +114,7 @@ LabelModel::find( std::function< bool( const Label& ) > predicate ) const
 {
     for ( int row = 0; row < m_locales.count(); ++row )
     {
-        if ( predicate( *m_locales[ row ] ) )
+        if ( predicate( m_locales[ row ] ) )
         {
             return row;
         }
@@ -129,12 +143,7 @@ LabelModel::find( const QString& countryCode ) const
     }
 
     auto c_l = countryData( countryCode );
-    int r = find( [&]( const Label& l ) { return ( l.language() == c_l.second ) && ( l.country() == c_l.first ); } );
-    if ( r >= 0 )
-    {
-        return r;
-    }
-    return find( [&]( const Label& l ) { return l.language() == c_l.second; } );
+    return m_rowForLocale.value( localeKey( c_l.second, c_l.first ), m_rowForLanguage.value( int( c_l.second ), -1 ) );
 }
 
 LabelModel*
@@ -24,6 +24,7 @@
 #include "Label.h"
 
 #include <QAbstractListModel>
+#include <QHash>
 #include <QVector>
 
 
@@ -73,8 +74,15 @@ public:
     int find( const QString& countryCode ) const;
 
 private:
-    QVector< Label* > m_locales;
+    QVector< Label > m_locales;
     QStringList m_localeIds;
+
+    /// @brief Key for language + country in m_rowForLocale
+    static int localeKey( QLocale::Language l, QLocale::Country c ) { return int( l ) * 1024 + int( c ); }
+    /// @brief First row with a given language (QLocale::Language as int)
+    QHash< int, int > m_rowForLanguage;
+    /// @brief First row with a given language and country (see localeKey())
+    QHash< int, int > m_rowForLocale;
 };
 
 /** @brief Returns a model with all available translations.
@@ -42,23 +42,59 @@ struct TwoChar
     char cc2;
 };
 
-static const CountryData*
-lookup( TwoChar c )
+/** @brief Direct-indexed tables into country_data_table
+ *
+ * Every 2-letter (uppercase) code has its own slot in byCode, and
+ * every QLocale::Country has a slot in byCountry. A slot holds
+ * 1 + the index of the (first) matching entry in country_data_table,
+ * or 0 if there is none. The tables are built by the compiler.
+ */
+struct CountryIndex
 {
-    if ( !c.cc1 )
+    static constexpr int codeCount = 26 * 26;
+    static constexpr int countryCount = int( QLocale::LastCountry ) + 1;
+
+    unsigned char byCode[ codeCount ];
+    unsigned char byCountry[ countryCount ];
+
+    static constexpr int codeSlot( char cc1, char cc2 )
     {
-        return nullptr;
+        return ( cc1 >= 'A' && cc1 <= 'Z' && cc2 >= 'A' && cc2 <= 'Z' ) ? ( cc1 - 'A' ) * 26 + ( cc2 - 'A' ) : -1;
     }
 
-    const CountryData* p
-        = std::find_if( country_data_table, country_data_table + country_data_size, [c = c]( const CountryData& d ) {
-              return ( d.cc1 == c.cc1 ) && ( d.cc2 == c.cc2 );
-          } );
-    if ( p == country_data_table + country_data_size )
+    constexpr CountryIndex()
+        : byCode {}
+        , byCountry {}
+    {
+        // Backwards, so that the first match in the table wins
+        for ( int i = country_data_size - 1; i >= 0; --i )
+        {
+            const CountryData& d = country_data_table[ i ];
+            const int slot = codeSlot( d.cc1, d.cc2 );
+            if ( slot >= 0 )
+            {
+                byCode[ slot ] = static_cast< unsigned char >( i + 1 );
+            }
+            if ( int( d.c ) < countryCount )
+            {
+                byCountry[ int( d.c ) ] = static_cast< unsigned char >( i + 1 );
+            }
+        }
+    }
+};
+
+static_assert( country_data_size < 255, "Country table too large for 8-bit index" );
+static constexpr const CountryIndex country_index {};
+
+static const CountryData*
+lookup( TwoChar c )
+{
+    const int slot = CountryIndex::codeSlot( c.cc1, c.cc2 );
+    if ( slot < 0 || !country_index.byCode[ slot ] )
     {
         return nullptr;
     }
-    return p;
+    return country_data_table + country_index.byCode[ slot ] - 1;
 }
 
 QLocale::Country
@@ -92,14 +128,12 @@ countryLocale( const QString& code )
 QLocale::Language
 languageForCountry( QLocale::Country country )
 {
-    const CountryData* p = std::find_if( country_data_table,
-                                         country_data_table + country_data_size,
-                                         [c = country]( const CountryData& d ) { return d.c == c; } );
-    if ( p == country_data_table + country_data_size )
+    const int c = int( country );
+    if ( c < 0 || c >= CountryIndex::countryCount || !country_index.byCountry[ c ] )
     {
         return QLocale::Language::AnyLanguage;
     }
-    return p->l;
+    return country_data_table[ country_index.byCountry[ c ] - 1 ].l;
 }
 
 }  // namespace Locale
@@ -18,7 +18,9 @@
 
 #include "Tests.h"
 
+#include "locale/AvailableLocales.h"
 #include "locale/LabelModel.h"
+#include "locale/Lookup.h"
 #include "locale/TimeZone.h"
 #include "locale/TranslatableConfiguration.h"
 
@@ -27,6 +29,8 @@
 
 #include <QtTest/QtTest>
 
+#include <QTemporaryFile>
+
 QTEST_GUILESS_MAIN( LocaleTests )
 
 LocaleTests::LocaleTests() {}
@@ -100,6 +104,30 @@ someLanguages()
 }
 
 
+void
+LocaleTests::testCountryLookup()
+{
+    using namespace CalamaresUtils::Locale;
+
+    QCOMPARE( countryForCode( "NL" ), QLocale::Netherlands );
+    QCOMPARE( countryForCode( "AD" ), QLocale::Andorra );  // First in table
+    QCOMPARE( countryForCode( "ZW" ), QLocale::Zimbabwe );  // Last in table
+    QCOMPARE( countryForCode( "nl" ), QLocale::AnyCountry );
+    QCOMPARE( countryForCode( "NLD" ), QLocale::AnyCountry );
+    QCOMPARE( countryForCode( "Z9" ), QLocale::AnyCountry );
+    QCOMPARE( countryForCode( QString() ), QLocale::AnyCountry );
+
+    QCOMPARE( languageForCountry( "BE" ), QLocale::Dutch );
+    QCOMPARE( languageForCountry( QLocale::Belgium ), QLocale::Dutch );
+    QCOMPARE( languageForCountry( QLocale::India ), QLocale::AnyLanguage );  // Edited table
+    QCOMPARE( languageForCountry( QLocale::AnyCountry ), QLocale::AnyLanguage );
+
+    const auto c_l = countryData( "DE" );
+    QCOMPARE( c_l.first, QLocale::Germany );
+    QCOMPARE( c_l.second, QLocale::German );
+    QCOMPARE( countryLocale( "DE" ).name(), QStringLiteral( "de_DE" ) );
+}
+
 /** @brief Check consistency of test data
  * Check that all the languages used in testing, are actually enabled
  * in Calamares translations.
@@ -253,3 +281,92 @@ LocaleTests::testComplexZones()
         QCOMPARE( r.tr(), QStringLiteral( "zxc,;* vm" ) );  // Only _ is special
     }
 }
+
+void
+LocaleTests::testZoneTabFile()
+{
+    using namespace CalamaresUtils::Locale;
+
+    QTemporaryFile zoneTab;
+    QVERIFY( zoneTab.open() );
+    zoneTab.write( "# A comment\n"
+                   "NL\t+5222+00454\tEurope/Amsterdam\n"
+                   "US\t+404251-0740023\tAmerica/New_York\tEastern (most areas)\n"
+                   "AR\t-3436-05827\tAmerica/Argentina/Buenos_Aires\tBuenos Aires (BA, CF)\n"
+                   "\n"
+                   "XX\tbogus\n"
+                   "ES\t+3553-00519\tAfrica/Ceuta\tCeuta, Melilla # and a trailing comment\n" );
+    zoneTab.close();
+
+    CStringPairList regions = TZRegion::fromFile( zoneTab.fileName().toLocal8Bit().constData() );
+    QCOMPARE( regions.count(), 3 );
+    // Sorted by key
+    QCOMPARE( regions.at( 0 )->key(), QStringLiteral( "Africa" ) );
+    QCOMPARE( regions.at( 2 )->key(), QStringLiteral( "Europe" ) );
+
+    const auto* america = regions.find< TZRegion >( QStringLiteral( "America" ) );
+    QVERIFY( america );
+    QCOMPARE( america->zones().count(), 2 );
+    QVERIFY( !regions.find< TZRegion >( QStringLiteral( "Asia" ) ) );
+
+    const auto* newYork = america->zones().find< TZZone >( QStringLiteral( "New_York" ) );
+    QVERIFY( newYork );
+    QCOMPARE( newYork->country(), QStringLiteral( "US" ) );
+    QCOMPARE( newYork->tr(), QStringLiteral( "New York" ) );
+    QVERIFY( newYork->latitude() > 40.7 && newYork->latitude() < 40.8 );
+    QVERIFY( newYork->longitude() < -74.0 && newYork->longitude() > -74.1 );
+
+    const auto* buenosAires = america->zones().find< TZZone >( QStringLiteral( "Argentina/Buenos_Aires" ) );
+    QVERIFY( buenosAires );
+    QCOMPARE( buenosAires->region(), QStringLiteral( "America" ) );
+    QVERIFY( buenosAires->latitude() < 0 );
+
+    // Zones are not found in the wrong region
+    QVERIFY( !regions.find< TZRegion >( QStringLiteral( "Europe" ) )->zones().find< TZZone >( "New_York" ) );
+
+    // The index does not give wrong answers after the list changes
+    CStringPairList copy = regions;
+    copy.removeFirst();
+    QVERIFY( copy.find< TZRegion >( QStringLiteral( "America" ) ) );
+    QVERIFY( !copy.find< TZRegion >( QStringLiteral( "Africa" ) ) );
+
+    qDeleteAll( regions );
+}
+
+void
+LocaleTests::testAvailableLocales()
+{
+    // Like /usr/share/i18n/SUPPORTED
+    {
+        const QByteArray supported( "aa_DJ.UTF-8 UTF-8\n"
+                                    "aa_DJ ISO-8859-1\n"
+                                    "\n"
+                                    "en_US.UTF-8 UTF-8\n"
+                                    "en_US ISO-8859-1\n"
+                                    "sr_RS@latin UTF-8\n" );
+        QCOMPARE( CalamaresUtils::Locale::AvailableLocales::fromData( supported, false ),
+                  QStringList() << "aa_DJ.UTF-8"
+                                << "en_US.UTF-8"
+                                << "sr_RS@latin" );
+    }
+    // Like /etc/locale.gen
+    {
+        const QByteArray localeGen( "# This file lists locales that you wish to have built.\n"
+                                    "#\n"
+                                    "## A double-comment\n"
+                                    "#  en_GB.UTF-8 UTF-8 is commented out with spaces\n"
+                                    "#de_DE.UTF-8 UTF-8\n"
+                                    "#de_DE ISO-8859-1\n"
+                                    "nl_NL.UTF-8 UTF-8\n" );
+        QCOMPARE( CalamaresUtils::Locale::AvailableLocales::fromData( localeGen, true ),
+                  QStringList() << "de_DE.UTF-8"
+                                << "nl_NL.UTF-8" );
+    }
+    // Like `locale -a`
+    {
+        const QByteArray localeA( "C\nC.utf8\nPOSIX\nen_US.utf8\n" );
+        QCOMPARE( CalamaresUtils::Locale::AvailableLocales::fromData( localeA, true ),
+                  QStringList() << "C.utf8"
+                                << "en_US.utf8" );
+    }
+}
@@ -33,6 +33,7 @@ private Q_SLOTS:
 
     void testLanguageModelCount();
     void testEsperanto();
+    void testCountryLookup();
     void testTranslatableLanguages();
     void testTranslatableConfig1();
     void testTranslatableConfig2();
@@ -40,6 +41,9 @@ private Q_SLOTS:
     // TimeZone testing
     void testSimpleZones();
     void testComplexZones();
+    void testZoneTabFile();
+
+    void testAvailableLocales();
 };
 
 #endif
@@ -21,10 +21,6 @@
 #include "utils/Logger.h"
 
 #include <QFile>
-#include <QStringList>
-#include <QTextStream>
-
-#include <cstring>
 
 static const char TZ_DATA_FILE[] = "/usr/share/zoneinfo/zone.tab";
 
@@ -64,57 +60,50 @@ namespace Locale
 
 
 CStringPair::CStringPair( CStringPair&& t )
-    : m_human( nullptr )
+    : m_human()
     , m_key()
 {
-    // My pointers are initialized to nullptr
     std::swap( m_human, t.m_human );
     std::swap( m_key, t.m_key );
 }
 
 CStringPair::CStringPair( const CStringPair& t )
-    : m_human( t.m_human ? strdup( t.m_human ) : nullptr )
+    : m_human( t.m_human )
     , m_key( t.m_key )
 {
 }
 
 /** @brief Massage an identifier into a human-readable form
  *
- * Makes a copy of @p s, caller must free() it.
+ * This is replace("_"," ") in the Python script.
  */
-static char*
+static QByteArray
 munge( const char* s )
 {
-    char* t = strdup( s );
-    if ( !t )
-    {
-        return nullptr;
-    }
-
-    // replace("_"," ") in the Python script
-    char* p = t;
-    while ( *p )
-    {
-        if ( ( *p ) == '_' )
-        {
-            *p = ' ';
-        }
-        ++p;
-    }
-
+    QByteArray t( s );
+    t.replace( '_', ' ' );
     return t;
 }
 
 CStringPair::CStringPair( const char* s1 )
-    : m_human( s1 ? munge( s1 ) : nullptr )
+    : m_human( s1 ? munge( s1 ) : QByteArray() )
     , m_key( s1 ? QString( s1 ) : QString() )
 {
 }
 
 
-CStringPair::~CStringPair()
+CStringPair::~CStringPair() {}
+
+
+void
+CStringPairList::reindex()
 {
-    free( m_human );
+    m_index.clear();
+    m_index.reserve( count() );
+    for ( int i = 0; i < count(); ++i )
+    {
+        m_index.insert( at( i )->key(), i );
+    }
 }
 
 
@@ -122,7 +111,7 @@ QString
 TZRegion::tr() const
 {
     // NOTE: context name must match what's used in zone-extractor.py
-    return QObject::tr( m_human, "tz_regions" );
+    return QObject::tr( m_human.constData(), "tz_regions" );
 }
 
 TZRegion::~TZRegion()
@@ -143,82 +132,86 @@ TZRegion::fromFile( const char* fileName )
     CStringPairList model;
 
     QFile file( fileName );
-    if ( !file.open( QIODevice::ReadOnly | QIODevice::Text ) )
+    if ( !file.open( QIODevice::ReadOnly ) )
     {
         return model;
     }
 
-    TZRegion* thisRegion = nullptr;
-    QTextStream in( &file );
-    while ( !in.atEnd() )
+    // zone.tab is small (a few dozen KiB), and pure ASCII;
+    // splitting the raw bytes is much cheaper than a QTextStream.
+    const QByteArray data = file.readAll();
+    QHash< QString, TZRegion* > regions;
+
+    for ( const QByteArray& rawLine : data.split( '\n' ) )
     {
-        QString line = in.readLine().trimmed().split( '#', QString::KeepEmptyParts ).first().trimmed();
+        const int comment = rawLine.indexOf( '#' );
+        const QByteArray line = ( comment < 0 ? rawLine : rawLine.left( comment ) ).trimmed();
         if ( line.isEmpty() )
         {
             continue;
         }
 
-        QStringList list = line.split( QRegExp( "[\t ]" ), QString::SkipEmptyParts );
+        // Columns are country, coordinates, zone and (optional) comments
+        const QList< QByteArray > list = line.simplified().split( ' ' );
         if ( list.size() < 3 )
         {
             continue;
         }
 
-        QStringList timezoneParts = list.at( 2 ).split( '/', QString::SkipEmptyParts );
-        if ( timezoneParts.size() < 2 )
+        const QByteArray& timezone = list.at( 2 );
+        const int slash = timezone.indexOf( '/' );
+        if ( slash <= 0 || slash == timezone.length() - 1 )
         {
             continue;
         }
 
-        QString region = timezoneParts.first().trimmed();
-        if ( region.isEmpty() )
-        {
-            continue;
-        }
-
-        auto keyMatch = [&region]( const CStringPair* r ) { return r->key() == region; };
-        auto it = std::find_if( model.begin(), model.end(), keyMatch );
-        if ( it != model.end() )
-        {
-            thisRegion = dynamic_cast< TZRegion* >( *it );
-        }
-        else
+        const QString region = QString::fromLatin1( timezone.left( slash ) );
+        TZRegion*& thisRegion = regions[ region ];
+        if ( !thisRegion )
         {
-            thisRegion = new TZRegion( region.toUtf8().data() );
+            thisRegion = new TZRegion( timezone.left( slash ).constData() );
             model.append( thisRegion );
         }
 
-        QString countryCode = list.at( 0 ).trimmed();
+        const QByteArray& countryCode = list.at( 0 );
         if ( countryCode.size() != 2 )
         {
             continue;
         }
 
-        timezoneParts.removeFirst();
-        thisRegion->m_zones.append(
-            new TZZone( region, timezoneParts.join( '/' ).toUtf8().constData(), countryCode, list.at( 1 ) ) );
+        thisRegion->m_zones.append( new TZZone( region,
+                                                timezone.mid( slash + 1 ).constData(),
+                                                QString::fromLatin1( countryCode ),
+                                                QString::fromLatin1( list.at( 1 ) ) ) );
     }
 
     auto sorter = []( const CStringPair* l, const CStringPair* r ) { return *l < *r; };
     std::sort( model.begin(), model.end(), sorter );
-    for ( auto& it : model )
+    model.reindex();
+    for ( auto* r : regions )
     {
-        TZRegion* r = dynamic_cast< TZRegion* >( it );
-        if ( r )
-        {
-            std::sort( r->m_zones.begin(), r->m_zones.end(), sorter );
-        }
+        std::sort( r->m_zones.begin(), r->m_zones.end(), sorter );
+        r->m_zones.reindex();
     }
 
     return model;
 }
 
-TZZone::TZZone( const QString& region, const char* zoneName, const QString& country, QString position )
+TZZone::TZZone( const QString& region, const char* zoneName, const QString& country, const QString& position )
     : CStringPair( zoneName )
     , m_region( region )
     , m_country( country )
 {
-    int cooSplitPos = position.indexOf( QRegExp( "[-+]" ), 1 );
+    // Latitude and longitude are run together, e.g. +4230+00131
+    int cooSplitPos = -1;
+    for ( int i = 1; i < position.length(); ++i )
+    {
+        if ( position.at( i ) == '-' || position.at( i ) == '+' )
+        {
+            cooSplitPos = i;
+            break;
+        }
+    }
     if ( cooSplitPos > 0 )
     {
         m_latitude = getRightGeoLocation( position.mid( 0, cooSplitPos ) );
@@ -230,7 +223,7 @@ QString
 TZZone::tr() const
 {
     // NOTE: context name must match what's used in zone-extractor.py
-    return QObject::tr( m_human, "tz_names" );
+    return QObject::tr( m_human.constData(), "tz_names" );
 }
 
 
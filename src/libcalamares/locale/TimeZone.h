@@ -24,6 +24,8 @@
 #include "utils/Logger.h"
 
 #include <QAbstractListModel>
+#include <QByteArray>
+#include <QHash>
 #include <QObject>
 #include <QString>
 
@@ -63,16 +65,28 @@ public:
     bool operator<( const CStringPair& other ) const { return m_key < other.m_key; }
 
 protected:
-    char* m_human = nullptr;
+    QByteArray m_human;
     QString m_key;
 };
 
+/** @brief A list of pairs, with lookup-by-key
+ *
+ * Lists produced by TZRegion::fromFile() carry an index from
+ * key to position, so find() is a hash lookup. The index is
+ * checked against the list itself, so a list that was modified
+ * after reindex() is still searched correctly (just slower).
+ */
 class CStringPairList : public QList< CStringPair* >
 {
 public:
     template < typename T >
     T* find( const QString& key ) const
     {
+        const int i = m_index.value( key, -1 );
+        if ( i >= 0 && i < count() && at( i )->key() == key )
+        {
+            return dynamic_cast< T* >( at( i ) );
+        }
         for ( auto* p : *this )
         {
             if ( p->key() == key )
@@ -82,6 +96,12 @@ public:
         }
         return nullptr;
     }
+
+    /// @brief Rebuild the index used by find(), after changing the list
+    void reindex();
+
+private:
+    QHash< QString, int > m_index;
 };
 
 /// @brief A pair of strings for timezone regions (e.g. "America")
@@ -105,9 +125,14 @@ public:
      *
      * The list owns the regions, and the regions own their own list of zones.
      * When getting rid of the list, remember to qDeleteAll() on it.
+     *
+     * The lists are sorted by key and indexed, so find() on them is cheap.
      */
     static CStringPairList fromFile( const char* fileName );
-    /// @brief Calls fromFile with the standard zone.tab name
+    /** @brief Calls fromFile with the standard zone.tab name
+     *
+     * The file is read only once; later calls return the same list.
+     */
     static const CStringPairList& fromZoneTab();
 
     const CStringPairList& zones() const { return m_zones; }
@@ -124,7 +149,7 @@ public:
     using CStringPair::CStringPair;
     QString tr() const override;
 
-    TZZone( const QString& region, const char* zoneName, const QString& country, QString position );
+    TZZone( const QString& region, const char* zoneName, const QString& country, const QString& position );
 
     QString region() const { return m_region; }
     QString zone() const { return key(); }
@@ -269,7 +269,7 @@ def export_class(cls, data):
         f.write("\nstatic constexpr int const {!s}_size = {!s};\n".format(
             identifier,
             len(data)))
-        f.write("\nstatic const {!s} {!s}_table[] = {!s}\n".format(
+        f.write("\nstatic constexpr const {!s} {!s}_table[] = {!s}\n".format(
             cls.cpp_classname,
             identifier,
             "{"))
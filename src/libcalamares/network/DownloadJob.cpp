@@ -0,0 +1,480 @@
+/* === This file is part of Calamares - <https://github.com/calamares> ===
+ *
+ *   Copyright 2020, agent <agent@local>
+ *
+ *   Calamares is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Calamares is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Calamares. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DownloadJob.h"
+
+#include "Manager.h"
+
+#include "utils/Logger.h"
+
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTimer>
+
+#include <algorithm>
+#include <memory>
+
+namespace CalamaresUtils
+{
+namespace Network
+{
+
+/// How often a single file is tried before giving up
+static constexpr int s_maxAttempts = 3;
+/// A download that receives no data for this long is aborted (and retried)
+static constexpr int s_stallTimeout = 60000;  // msec
+/// With a bandwidth limit, data is read from the network this often
+static constexpr int s_throttleInterval = 100;  // msec
+
+/** @brief Does the checksum of @p fileName match @p request ?
+ *
+ * Always matches if the request has no checksum.
+ */
+static bool
+checksumMatches( const QString& fileName, const DownloadRequest& request )
+{
+    if ( request.checksum.isEmpty() )
+    {
+        return true;
+    }
+
+    QFile f( fileName );
+    if ( !f.open( QIODevice::ReadOnly ) )
+    {
+        return false;
+    }
+    QCryptographicHash hash( request.algorithm );
+    hash.addData( &f );
+    return hash.result().toHex() == request.checksum.toLower();
+}
+
+/// @brief State of one (active) download
+struct Transfer
+{
+    int index = -1;  ///< Index in the list of requests
+    int attempts = 0;
+    std::unique_ptr< QFile > file;
+    QNetworkReply* reply = nullptr;
+    QTimer* stallTimer = nullptr;
+    qint64 offset = 0;  ///< Bytes already in the file when the request was sent
+    qint64 received = 0;  ///< Bytes received for this request
+    qint64 total = -1;  ///< Expected size of the whole file, if known
+    bool accepted = false;  ///< Is the body of the reply (part of) the file?
+    bool writeFailed = false;
+};
+
+/** @brief The total size from the Content-Range header of @p reply
+ *
+ * A server that can't satisfy a range still sends the size of the
+ * whole file, after the slash in the Content-Range header.
+ * Returns -1 if there is no (usable) Content-Range header.
+ */
+static qint64
+contentRangeTotal( const QNetworkReply* reply )
+{
+    const QByteArray range = reply->rawHeader( "Content-Range" );
+    const int slash = range.lastIndexOf( '/' );
+    if ( slash < 0 )
+    {
+        return -1;
+    }
+    bool ok = false;
+    const qint64 total = range.mid( slash + 1 ).trimmed().toLongLong( &ok );
+    return ok ? total : -1;
+}
+
+class DownloadJob::Private : public QObject
+{
+public:
+    explicit Private( DownloadJob* job )
+        : m_job( job )
+        , m_requests( job->m_requests )
+    {
+    }
+
+    /// @brief Runs all the downloads; returns the requests that failed
+    QStringList run();
+
+private:
+    /// @brief Start downloads until there are enough running
+    void startMore();
+    /// @brief (Re)starts @p t, resuming from what is on disk
+    void start( Transfer* t );
+    void headersReceived( Transfer* t );
+    /// @brief Writes (at most @p maxSize) received data; returns @c false if writing failed
+    bool write( Transfer* t, qint64 maxSize );
+    /// @brief Aborts @p t because its file can't be written
+    void writeFailed( Transfer* t );
+    void finished( Transfer* t );
+    void throttle();
+    void reportProgress();
+
+    DownloadJob* m_job;
+    const QVector< DownloadRequest >& m_requests;
+
+    QEventLoop m_loop;
+    QTimer* m_throttleTimer = nullptr;
+    std::vector< std::unique_ptr< Transfer > > m_active;
+    int m_next = 0;  ///< Index of the next request to start
+    int m_done = 0;  ///< Number of completed requests (failed or not)
+    QStringList m_failed;
+};
+
+QStringList
+DownloadJob::Private::run()
+{
+    if ( m_job->m_bandwidthLimit > 0 )
+    {
+        m_throttleTimer = new QTimer( this );
+        connect( m_throttleTimer, &QTimer::timeout, this, &Private::throttle );
+        m_throttleTimer->start( s_throttleInterval );
+    }
+
+    startMore();
+    if ( !m_active.empty() )
+    {
+        m_loop.exec();
+    }
+    return m_failed;
+}
+
+void
+DownloadJob::Private::startMore()
+{
+    while ( int( m_active.size() ) < m_job->m_parallel && m_next < m_requests.count() )
+    {
+        const int index = m_next++;
+        const auto& request = m_requests.at( index );
+
+        // A file from an earlier run that is known to be good is not downloaded again
+        if ( !request.checksum.isEmpty() && QFile::exists( request.destination )
+             && checksumMatches( request.destination, request ) )
+        {
+            cDebug() << "Download" << request.destination << "is already complete.";
+            m_done++;
+            continue;
+        }
+
+        auto t = std::make_unique< Transfer >();
+        t->index = index;
+        Transfer* transfer = t.get();
+        m_active.push_back( std::move( t ) );
+        start( transfer );
+    }
+    reportProgress();
+    if ( m_active.empty() )
+    {
+        m_loop.quit();
+    }
+}
+
+void
+DownloadJob::Private::start( Transfer* t )
+{
+    const auto& request = m_requests.at( t->index );
+    const QString partName = request.destination + QStringLiteral( ".part" );
+
+    t->attempts++;
+    t->received = 0;
+    t->total = -1;
+    t->accepted = false;
+
+    QDir().mkpath( QFileInfo( request.destination ).absolutePath() );
+    t->file = std::make_unique< QFile >( partName );
+    // Unbuffered, so that a failing write shows up right away
+    if ( !t->file->open( QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered ) )
+    {
+        cWarning() << "Could not open" << partName << "for download.";
+        t->attempts = s_maxAttempts;
+        QTimer::singleShot( 0, this, [ this, t ]() { finished( t ); } );
+        return;
+    }
+    t->offset = t->file->size();
+
+    QNetworkRequest networkRequest( request.url );
+    if ( t->offset > 0 )
+    {
+        cDebug() << "Resuming download of" << request.url << "at" << t->offset;
+        networkRequest.setRawHeader( "Range", QByteArray( "bytes=" ) + QByteArray::number( t->offset ) + '-' );
+    }
+
+    t->reply = Manager::instance().asynchronousGet( networkRequest, RequestOptions( RequestOptions::FollowRedirect ) );
+    if ( !t->reply )
+    {
+        QTimer::singleShot( 0, this, [ this, t ]() { finished( t ); } );
+        return;
+    }
+    if ( m_throttleTimer )
+    {
+        // Keep the buffer small, so the limit applies to the socket too
+        t->reply->setReadBufferSize( m_job->m_bandwidthLimit * s_throttleInterval / 1000 + 1 );
+    }
+
+    t->stallTimer = new QTimer( t->reply );
+    t->stallTimer->setSingleShot( true );
+    connect( t->stallTimer, &QTimer::timeout, t->reply, &QNetworkReply::abort );
+    t->stallTimer->start( s_stallTimeout );
+
+    connect( t->reply, &QNetworkReply::metaDataChanged, this, [ this, t ]() { headersReceived( t ); } );
+    connect( t->reply, &QNetworkReply::readyRead, this, [ this, t ]() {
+        t->stallTimer->start( s_stallTimeout );
+        if ( !m_throttleTimer && !write( t, t->reply->bytesAvailable() ) )
+        {
+            writeFailed( t );
+        }
+    } );
+    connect( t->reply, &QNetworkReply::finished, this, [ this, t ]() { finished( t ); } );
+}
+
+void
+DownloadJob::Private::headersReceived( Transfer* t )
+{
+    // Only a 200 (the whole file) or a 206 (the rest of it) carries file data;
+    // for anything else, the body is an error page. A status of 0 means that
+    // this isn't HTTP at all (e.g. a file: URL), which has no ranges either.
+    const int status = t->reply->attribute( QNetworkRequest::HttpStatusCodeAttribute ).toInt();
+    t->accepted = status == 0 || status == 200 || ( status == 206 && t->offset > 0 );
+    if ( !t->accepted )
+    {
+        return;
+    }
+    if ( t->offset > 0 && status != 206 )
+    {
+        // The server sends the whole file, not the requested range
+        cDebug() << "Download of" << t->reply->url() << "can not be resumed, restarting.";
+        t->file->resize( 0 );
+        t->offset = 0;
+    }
+
+    bool ok = false;
+    const qint64 length = t->reply->header( QNetworkRequest::ContentLengthHeader ).toLongLong( &ok );
+    t->total = ok ? t->offset + length : -1;
+}
+
+bool
+DownloadJob::Private::write( Transfer* t, qint64 maxSize )
+{
+    if ( !t->accepted )
+    {
+        // Not every kind of reply announces its headers before the data
+        headersReceived( t );
+    }
+    const QByteArray data = t->reply->read( maxSize );
+    if ( data.isEmpty() || !t->accepted )
+    {
+        // Data that is not part of the file is dropped
+        return true;
+    }
+    if ( t->file->write( data ) != data.size() )
+    {
+        cWarning() << "Could not write to" << t->file->fileName();
+        return false;
+    }
+    t->received += data.size();
+    reportProgress();
+    return true;
+}
+
+void
+DownloadJob::Private::writeFailed( Transfer* t )
+{
+    // Trying again won't help; finished() is called from abort()
+    t->writeFailed = true;
+    t->reply->abort();
+}
+
+void
+DownloadJob::Private::throttle()
+{
+    qint64 budget = m_job->m_bandwidthLimit * s_throttleInterval / 1000;
+    // Share the budget between the downloads that have data
+    for ( const auto& t : m_active )
+    {
+        if ( t->reply && t->reply->bytesAvailable() > 0 && budget > 0 )
+        {
+            const qint64 size = qMin( budget, t->reply->bytesAvailable() );
+            budget -= size;
+            if ( !write( t.get(), size ) )
+            {
+                writeFailed( t.get() );
+                // That may have removed t from m_active
+                break;
+            }
+        }
+    }
+}
+
+void
+DownloadJob::Private::finished( Transfer* t )
+{
+    const auto& request = m_requests.at( t->index );
+    bool success = false;
+    bool retry = false;
+    bool discard = false;  // Remove the .part file, it can't be resumed
+
+    if ( t->reply )
+    {
+        // No more signals, also not from the last write() below
+        t->reply->disconnect( this );
+        t->reply->deleteLater();
+        if ( !t->accepted )
+        {
+            headersReceived( t );
+        }
+
+        const int status = t->reply->attribute( QNetworkRequest::HttpStatusCodeAttribute ).toInt();
+        if ( t->writeFailed )
+        {
+            discard = true;
+        }
+        else if ( t->reply->error() == QNetworkReply::NoError && t->accepted )
+        {
+            success = write( t, t->reply->bytesAvailable() );
+            discard = !success;
+        }
+        else if ( status == 416 && t->offset > 0 )
+        {
+            // Range not satisfiable: the .part file may be complete already,
+            // or it may be longer than the file (and then it is junk).
+            if ( contentRangeTotal( t->reply ) == t->offset )
+            {
+                success = true;
+            }
+            else
+            {
+                cDebug() << "Download of" << request.url << "does not match" << t->file->fileName() << ", restarting.";
+                t->file->resize( 0 );
+                retry = true;
+            }
+        }
+        else
+        {
+            cWarning() << "Download of" << request.url << "failed:" << status << t->reply->errorString();
+            // Client errors, or a success without the file, won't get better by trying again
+            retry = t->reply->error() != QNetworkReply::NoError
+                && ( status < 400 || status == 408 || status == 429 || status >= 500 );
+            discard = !retry;
+        }
+        t->reply = nullptr;
+    }
+    t->file->close();
+
+    if ( success && !checksumMatches( t->file->fileName(), request ) )
+    {
+        cWarning() << "Download of" << request.url << "has the wrong checksum.";
+        t->file->remove();
+        success = false;
+        retry = true;
+    }
+
+    if ( success )
+    {
+        QFile::remove( request.destination );
+        success = t->file->rename( request.destination );
+        if ( !success )
+        {
+            cWarning() << "Could not rename download to" << request.destination;
+        }
+    }
+    else if ( retry && t->attempts < s_maxAttempts )
+    {
+        start( t );
+        return;
+    }
+
+    if ( !success )
+    {
+        if ( discard )
+        {
+            t->file->remove();
+        }
+        m_failed.append( request.url.toString() );
+    }
+    m_done++;
+
+    auto it = std::find_if(
+        m_active.begin(), m_active.end(), [ t ]( const std::unique_ptr< Transfer >& p ) { return p.get() == t; } );
+    if ( it != m_active.end() )
+    {
+        m_active.erase( it );
+    }
+    startMore();
+}
+
+void
+DownloadJob::Private::reportProgress()
+{
+    if ( m_requests.isEmpty() )
+    {
+        return;
+    }
+
+    // Each file counts the same; running downloads count partially
+    qreal done = m_done;
+    for ( const auto& t : m_active )
+    {
+        if ( t->total > 0 )
+        {
+            done += qreal( t->offset + t->received ) / qreal( t->total );
+        }
+    }
+
+    m_job->m_status = DownloadJob::tr( "Downloading files (%1 of %2 complete)." ).arg( m_done ).arg( m_requests.count() );
+    emit m_job->progress( qBound( 0.0, done / m_requests.count(), 1.0 ) );
+}
+
+
+DownloadJob::DownloadJob( const QVector< DownloadRequest >& requests, QObject* parent )
+    : Calamares::Job( parent )
+    , m_requests( requests )
+{
+}
+
+DownloadJob::~DownloadJob() {}
+
+QString
+DownloadJob::prettyName() const
+{
+    return tr( "Download files" );
+}
+
+QString
+DownloadJob::prettyStatusMessage() const
+{
+    return m_status.isEmpty() ? prettyName() : m_status;
+}
+
+Calamares::JobResult
+DownloadJob::exec()
+{
+    Private d( this );
+    const QStringList failed = d.run();
+    if ( failed.isEmpty() )
+    {
+        return Calamares::JobResult::ok();
+    }
+    return Calamares::JobResult::error( tr( "Could not download %n file(s).", "", failed.count() ),
+                                        failed.join( QStringLiteral( "\n" ) ) );
+}
+
+}  // namespace Network
+}  // namespace CalamaresUtils
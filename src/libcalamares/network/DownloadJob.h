@@ -0,0 +1,86 @@
+/* === This file is part of Calamares - <https://github.com/calamares> ===
+ *
+ *   Copyright 2020, agent <agent@local>
+ *
+ *   Calamares is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Calamares is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Calamares. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBCALAMARES_NETWORK_DOWNLOADJOB_H
+#define LIBCALAMARES_NETWORK_DOWNLOADJOB_H
+
+#include "DllMacro.h"
+#include "Job.h"
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QString>
+#include <QUrl>
+#include <QVector>
+
+namespace CalamaresUtils
+{
+namespace Network
+{
+/// @brief One file to download, for DownloadJob
+struct DownloadRequest
+{
+    QUrl url;
+    QString destination;  ///< Path of the downloaded file
+    QByteArray checksum;  ///< Expected checksum (in hex), or empty to skip verification
+    QCryptographicHash::Algorithm algorithm = QCryptographicHash::Sha256;
+};
+
+/** @brief Downloads files to disk, several at a time
+ *
+ * Each file is streamed to `<destination>.part`, and renamed to
+ * its destination once it is complete and its checksum (if given)
+ * has been verified. A `.part` file left over from an earlier attempt
+ * is resumed with an HTTP range request; if the server does not
+ * support ranges, the file is downloaded from the start.
+ *
+ * A failed download is retried (resuming where it left off) a few
+ * times before the job gives up. Errors that won't go away by
+ * trying again -- a client error from the server, or a file that
+ * can't be written -- fail right away, and remove the `.part` file.
+ * Progress is reported through the usual Job::progress() signal.
+ */
+class DLLEXPORT DownloadJob : public Calamares::Job
+{
+    Q_OBJECT
+public:
+    explicit DownloadJob( const QVector< DownloadRequest >& requests, QObject* parent = nullptr );
+    ~DownloadJob() override;
+
+    /// @brief How many downloads run at the same time (default 4)
+    void setParallelDownloads( int n ) { m_parallel = qMax( 1, n ); }
+    /// @brief Limit the total bandwidth, in bytes per second; 0 (the default) for no limit
+    void setBandwidthLimit( qint64 bytesPerSecond ) { m_bandwidthLimit = qMax( qint64( 0 ), bytesPerSecond ); }
+
+    QString prettyName() const override;
+    QString prettyStatusMessage() const override;
+    Calamares::JobResult exec() override;
+
+private:
+    class Private;
+    friend class Private;
+
+    QVector< DownloadRequest > m_requests;
+    int m_parallel = 4;
+    qint64 m_bandwidthLimit = 0;
+    QString m_status;
+};
+
+}  // namespace Network
+}  // namespace CalamaresUtils
+#endif  // LIBCALAMARES_NETWORK_DOWNLOADJOB_H
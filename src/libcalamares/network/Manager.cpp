@@ -18,16 +18,23 @@
 
 #include "Manager.h"
 
+#include "utils/Dirs.h"
 #include "utils/Logger.h"
 
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
 #include <QEventLoop>
 #include <QMutex>
 #include <QMutexLocker>
 #include <QNetworkAccessManager>
+#include <QNetworkDiskCache>
 #include <QNetworkReply>
 #include <QNetworkRequest>
 #include <QThread>
+#include <QThreadStorage>
 #include <QTimer>
+#include <QWaitCondition>
 
 namespace CalamaresUtils
 {
@@ -42,6 +49,22 @@ RequestOptions::applyToRequest( QNetworkRequest* request ) const
         request->setAttribute( QNetworkRequest::FollowRedirectsAttribute, true );
     }
 
+    if ( m_flags & Flag::CacheOnly )
+    {
+        request->setAttribute( QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysCache );
+    }
+    else if ( m_flags & Flag::UseCache )
+    {
+        // Uses the cached copy if it is fresh, revalidates it otherwise
+        request->setAttribute( QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferNetwork );
+        request->setAttribute( QNetworkRequest::CacheSaveControlAttribute, true );
+    }
+    else
+    {
+        request->setAttribute( QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork );
+        request->setAttribute( QNetworkRequest::CacheSaveControlAttribute, false );
+    }
+
     if ( m_flags & Flag::FakeUserAgent )
     {
         // Not everybody likes the default User Agent used by this class (looking at you,
@@ -50,94 +73,181 @@ RequestOptions::applyToRequest( QNetworkRequest* request ) const
     }
 }
 
-class Manager::Private : public QObject
+class Manager::Private
 {
-    Q_OBJECT
 private:
-    std::unique_ptr< QNetworkAccessManager > m_nam;
-
-    using ThreadNam = QPair< QThread*, QNetworkAccessManager* >;
-    QVector< ThreadNam > m_perThreadNams;
-
-public slots:
-    void cleanupNam();
+    /** @brief The NAM for each thread
+     *
+     * A QNetworkAccessManager can only be used from the thread that
+     * created it, so each thread gets its own. They are deleted
+     * (in their own thread) when the thread finishes. Worker
+     * threads from the global thread pool live on, so their NAMs
+     * -- and the connections those keep open -- are re-used.
+     */
+    QThreadStorage< QNetworkAccessManager* > m_perThreadNams;
 
 public:
-    QUrl m_hasInternetUrl;
+    QVector< QUrl > m_hasInternetUrls;
     bool m_hasInternet;
 
+    /// @brief Guards the connectivity-check state below (and m_hasInternet)
+    QMutex m_checkMutex;
+    QWaitCondition m_checkDone;
+    QElapsedTimer m_lastCheck;  ///< Invalid if there is no usable result
+    std::chrono::seconds m_hasInternetTtl;
+    QThread* m_checkThread;  ///< Thread running an async check, or nullptr
+
     Private();
 
     QNetworkAccessManager* nam();
+
+    /// @brief Is there a recent-enough connectivity result? Lock m_checkMutex first.
+    bool isFresh() const
+    {
+        return m_lastCheck.isValid() && m_lastCheck.elapsed() < qint64( m_hasInternetTtl.count() ) * 1000;
+    }
+    /// @brief Record a connectivity result; returns @c true if it changed
+    bool setHasInternet( bool hasInternet );
 };
 
+/** @brief Gives @p nam an on-disk HTTP cache
+ *
+ * Only the NAM of the main thread gets the cache. Each QNetworkDiskCache
+ * keeps its own idea of the size of the directory and expires entries
+ * based on that, so several of them on one directory would each
+ * overshoot the limit and remove each other's entries. Requests made
+ * from other threads do not use the cache. Does nothing if there is
+ * no cache directory.
+ */
+static void
+attachDiskCache( QNetworkAccessManager* nam )
+{
+    const auto* app = QCoreApplication::instance();
+    if ( !app || QThread::currentThread() != app->thread() )
+    {
+        return;
+    }
+
+    static const QString cacheDir = []() {
+        bool ok = false;
+        QDir dir = CalamaresUtils::appCacheDir( ok );
+        if ( ok && dir.mkpath( QStringLiteral( "network" ) ) )
+        {
+            return dir.absoluteFilePath( QStringLiteral( "network" ) );
+        }
+        return QString();
+    }();
+    if ( !cacheDir.isEmpty() )
+    {
+        auto* cache = new QNetworkDiskCache( nam );
+        cache->setCacheDirectory( cacheDir );
+        cache->setMaximumCacheSize( 16 * 1024 * 1024 );
+        nam->setCache( cache );
+    }
+}
+
 Manager::Private::Private()
-    : m_nam( std::make_unique< QNetworkAccessManager >() )
-    , m_hasInternet( false )
+    : m_hasInternet( false )
+    , m_hasInternetTtl( 30 )
+    , m_checkThread( nullptr )
 {
-    m_perThreadNams.reserve( 20 );
-    m_perThreadNams.append( qMakePair( QThread::currentThread(), m_nam.get() ) );
 }
 
-static QMutex*
-namMutex()
+bool
+Manager::Private::setHasInternet( bool hasInternet )
 {
-    static QMutex namMutex;
-    return &namMutex;
+    QMutexLocker lock( &m_checkMutex );
+    bool changed = hasInternet != m_hasInternet;
+    m_hasInternet = hasInternet;
+    m_lastCheck.start();
+    m_checkThread = nullptr;
+    m_checkDone.wakeAll();
+    return changed;
 }
 
 QNetworkAccessManager*
 Manager::Private::nam()
 {
-    QMutexLocker lock( namMutex() );
+    if ( !m_perThreadNams.hasLocalData() )
+    {
+        QNetworkAccessManager* nam = new QNetworkAccessManager();
+        attachDiskCache( nam );
+        m_perThreadNams.setLocalData( nam );
+    }
+    return m_perThreadNams.localData();
+}
 
-    auto* thread = QThread::currentThread();
-    int index = 0;
-    for ( const auto& n : m_perThreadNams )
+/** @brief Pings a list of URLs in parallel
+ *
+ * Emits finished( true ) as soon as one of the URLs returns data,
+ * or finished( false ) once all of them have failed. The requests
+ * that are still outstanding are then aborted.
+ */
+class ConnectivityProbe : public QObject
+{
+    Q_OBJECT
+public:
+    ConnectivityProbe( QNetworkAccessManager* nam, const QVector< QUrl >& urls, const RequestOptions& options )
+        : m_nam( nam )
+        , m_urls( urls )
+        , m_options( options )
     {
-        if ( n.first == thread )
-        {
-            return n.second;
-        }
-        ++index;
     }
 
-    // Need a new NAM for this thread
-    QNetworkAccessManager* nam = new QNetworkAccessManager();
-    m_perThreadNams.append( qMakePair( thread, nam ) );
-    QObject::connect( thread, &QThread::finished, this, &Manager::Private::cleanupNam );
+    /// @brief Sends the requests; connect to finished() before calling this
+    void start();
+    bool isDone() const { return m_done; }
 
-    return nam;
-}
+signals:
+    void finished( bool hasInternet );
 
-void
-Manager::Private::cleanupNam()
+private:
+    void replyFinished( QNetworkReply* reply );
+    void done( bool hasInternet );
+
+    QNetworkAccessManager* m_nam;
+    QVector< QUrl > m_urls;
+    RequestOptions m_options;
+    QVector< QNetworkReply* > m_replies;
+    int m_pending = 0;
+    bool m_done = false;
+};
+
+/// @brief Options used for each request of a connectivity check
+static RequestOptions
+probeOptions()
 {
-    QMutexLocker lock( namMutex() );
+    return RequestOptions( RequestOptions::FollowRedirect, std::chrono::seconds( 5 ) );
+}
+
 
-    auto* thread = QThread::currentThread();
-    bool cleanupFound = false;
-    int cleanupIndex = 0;
-    for ( const auto& n : m_perThreadNams )
+Manager::Manager()
+    : d( std::make_unique< Private >() )
+{
+    // The NAMs of other threads come and go with their threads, so only
+    // the one of the main thread is asked about accessibility.
+    const auto* app = QCoreApplication::instance();
+    if ( app && QThread::currentThread() != app->thread() )
     {
-        if ( n.first == thread )
-        {
-            cleanupFound = true;
-            delete n.second;
-            break;
-        }
-        ++cleanupIndex;
+        moveToThread( app->thread() );
+        QTimer::singleShot( 0, this, [ this ]() { watchAccessibility(); } );
     }
-    if ( cleanupFound )
+    else
     {
-        m_perThreadNams.remove( cleanupIndex );
+        watchAccessibility();
     }
 }
 
-
-Manager::Manager()
-    : d( std::make_unique< Private >() )
+void
+Manager::watchAccessibility()
 {
+    connect( d->nam(), &QNetworkAccessManager::networkAccessibleChanged, this, [ this ]() {
+        {
+            QMutexLocker lock( &d->m_checkMutex );
+            d->m_lastCheck.invalidate();
+        }
+        asynchronousCheckHasInternet();
+    } );
 }
 
 Manager::~Manager() {}
@@ -152,26 +262,150 @@ Manager::instance()
 bool
 Manager::hasInternet()
 {
+    QMutexLocker lock( &d->m_checkMutex );
     return d->m_hasInternet;
 }
 
 bool
 Manager::checkHasInternet()
 {
-    bool hasInternet = d->nam()->networkAccessible() == QNetworkAccessManager::Accessible;
+    QVector< QUrl > urls;
+    {
+        QMutexLocker lock( &d->m_checkMutex );
+        // Wait for a background check, unless it was started from this
+        // thread -- it can't complete while this thread is blocked.
+        while ( d->m_checkThread && d->m_checkThread != QThread::currentThread() )
+        {
+            d->m_checkDone.wait( &d->m_checkMutex );
+        }
+        if ( d->isFresh() )
+        {
+            return d->m_hasInternet;
+        }
+        urls = d->m_hasInternetUrls;
+    }
 
-    if ( !hasInternet && ( d->nam()->networkAccessible() == QNetworkAccessManager::UnknownAccessibility ) )
+    auto* nam = d->nam();
+    bool hasInternet = nam->networkAccessible() == QNetworkAccessManager::Accessible;
+    if ( !hasInternet && ( nam->networkAccessible() == QNetworkAccessManager::UnknownAccessibility ) )
     {
-        hasInternet = synchronousPing( d->m_hasInternetUrl );
+        ConnectivityProbe probe( nam, urls, probeOptions() );
+        QEventLoop loop;
+        connect( &probe, &ConnectivityProbe::finished, &loop, [ & ]( bool result ) {
+            hasInternet = result;
+            loop.quit();
+        } );
+        probe.start();
+        if ( !probe.isDone() )
+        {
+            loop.exec();
+        }
+    }
+
+    if ( d->setHasInternet( hasInternet ) )
+    {
+        emit hasInternetChanged( hasInternet );
     }
-    d->m_hasInternet = hasInternet;
     return hasInternet;
 }
 
+void
+Manager::asynchronousCheckHasInternet()
+{
+    QVector< QUrl > urls;
+    {
+        QMutexLocker lock( &d->m_checkMutex );
+        if ( d->m_checkThread || d->isFresh() )
+        {
+            return;
+        }
+        d->m_checkThread = QThread::currentThread();
+        urls = d->m_hasInternetUrls;
+    }
+
+    auto* nam = d->nam();
+    if ( nam->networkAccessible() != QNetworkAccessManager::UnknownAccessibility )
+    {
+        bool hasInternet = nam->networkAccessible() == QNetworkAccessManager::Accessible;
+        if ( d->setHasInternet( hasInternet ) )
+        {
+            emit hasInternetChanged( hasInternet );
+        }
+        return;
+    }
+
+    auto* probe = new ConnectivityProbe( nam, urls, probeOptions() );
+    connect( probe, &ConnectivityProbe::finished, probe, [ this, probe ]( bool hasInternet ) {
+        if ( d->setHasInternet( hasInternet ) )
+        {
+            emit hasInternetChanged( hasInternet );
+        }
+        probe->deleteLater();
+    } );
+    probe->start();
+}
+
 void
 Manager::setCheckHasInternetUrl( const QUrl& url )
 {
-    d->m_hasInternetUrl = url;
+    setCheckHasInternetUrl( QVector< QUrl > { url } );
+}
+
+void
+Manager::setCheckHasInternetUrl( const QVector< QUrl >& urls )
+{
+    QMutexLocker lock( &d->m_checkMutex );
+    d->m_hasInternetUrls = urls;
+    d->m_lastCheck.invalidate();
+}
+
+void
+Manager::setCheckHasInternetTtl( std::chrono::seconds ttl )
+{
+    QMutexLocker lock( &d->m_checkMutex );
+    d->m_hasInternetTtl = ttl;
+}
+
+static QMutex*
+metricsMutex()
+{
+    static QMutex metricsMutex;
+    return &metricsMutex;
+}
+
+static QHash< QString, HostMetrics >&
+hostMetrics()
+{
+    static QHash< QString, HostMetrics > metrics;
+    return metrics;
+}
+
+/** @brief Keeps track of the metrics of @p reply
+ *
+ * When the reply finishes, the request is added to the metrics
+ * of the host it was sent to.
+ */
+static void
+recordMetrics( QNetworkReply* reply )
+{
+    auto received = std::make_shared< qint64 >( 0 );
+    QElapsedTimer timer;
+    timer.start();
+
+    QObject::connect( reply, &QNetworkReply::downloadProgress, reply, [ received ]( qint64 bytes, qint64 ) {
+        *received = bytes;
+    } );
+    QObject::connect( reply, &QNetworkReply::finished, reply, [ reply, received, timer ]() {
+        QMutexLocker lock( metricsMutex() );
+        HostMetrics& m = hostMetrics()[ reply->request().url().host() ];
+        m.requests++;
+        if ( reply->error() != QNetworkReply::NoError )
+        {
+            m.failures++;
+        }
+        m.bytesReceived += *received;
+        m.totalLatency += std::chrono::milliseconds( timer.elapsed() );
+    } );
 }
 
 /** @brief Does a request asynchronously, returns the (pending) reply
@@ -183,9 +417,8 @@ Manager::setCheckHasInternetUrl( const QUrl& url )
  * On failure, returns nullptr (e.g. bad URL, timeout).
  */
 static QNetworkReply*
-asynchronousRun( QNetworkAccessManager* nam, const QUrl& url, const RequestOptions& options )
+asynchronousRun( QNetworkAccessManager* nam, QNetworkRequest request, const RequestOptions& options )
 {
-    QNetworkRequest request = QNetworkRequest( url );
     options.applyToRequest( &request );
 
     QNetworkReply* reply = nam->get( request );
@@ -198,6 +431,8 @@ asynchronousRun( QNetworkAccessManager* nam, const QUrl& url, const RequestOptio
         return nullptr;
     }
 
+    recordMetrics( reply );
+
     if ( options.hasTimeout() )
     {
         timer = new QTimer( reply );
@@ -220,7 +455,7 @@ asynchronousRun( QNetworkAccessManager* nam, const QUrl& url, const RequestOptio
 static QPair< RequestStatus, QNetworkReply* >
 synchronousRun( QNetworkAccessManager* nam, const QUrl& url, const RequestOptions& options )
 {
-    auto* reply = asynchronousRun( nam, url, options );
+    auto* reply = asynchronousRun( nam, QNetworkRequest( url ), options );
     if ( !reply )
     {
         return qMakePair( RequestStatus( RequestStatus::Failed ), nullptr );
@@ -272,13 +507,86 @@ Manager::synchronousGet( const QUrl& url, const RequestOptions& options )
     }
 
     auto reply = synchronousRun( d->nam(), url, options );
+    if ( !reply.first && ( options.flags() & RequestOptions::UseCache )
+         && !( options.flags() & RequestOptions::CacheOnly ) )
+    {
+        cDebug() << "Request for" << url << "failed" << reply.first << "trying cached copy.";
+        reply = synchronousRun(
+            d->nam(), url, RequestOptions( options.flags() | RequestOptions::CacheOnly, options.timeout() ) );
+    }
     return reply.first ? reply.second->readAll() : QByteArray();
 }
 
 QNetworkReply*
 Manager::asynchronousGet( const QUrl& url, const CalamaresUtils::Network::RequestOptions& options )
 {
-    return asynchronousRun( d->nam(), url, options );
+    return asynchronousRun( d->nam(), QNetworkRequest( url ), options );
+}
+
+QNetworkReply*
+Manager::asynchronousGet( const QNetworkRequest& request, const CalamaresUtils::Network::RequestOptions& options )
+{
+    return asynchronousRun( d->nam(), request, options );
+}
+
+QHash< QString, HostMetrics >
+Manager::metrics() const
+{
+    QMutexLocker lock( metricsMutex() );
+    return hostMetrics();
+}
+
+void
+ConnectivityProbe::start()
+{
+    for ( const auto& url : m_urls )
+    {
+        QNetworkReply* reply = url.isValid() ? asynchronousRun( m_nam, QNetworkRequest( url ), m_options ) : nullptr;
+        if ( reply )
+        {
+            reply->setParent( this );
+            m_replies.append( reply );
+            ++m_pending;
+            connect( reply, &QNetworkReply::finished, this, [ this, reply ]() { replyFinished( reply ); } );
+        }
+    }
+    if ( !m_pending )
+    {
+        done( false );
+    }
+}
+
+void
+ConnectivityProbe::replyFinished( QNetworkReply* reply )
+{
+    --m_pending;
+    if ( reply->error() == QNetworkReply::NoError && reply->bytesAvailable() )
+    {
+        done( true );
+    }
+    else if ( !m_pending )
+    {
+        done( false );
+    }
+}
+
+void
+ConnectivityProbe::done( bool hasInternet )
+{
+    if ( m_done )
+    {
+        return;
+    }
+    m_done = true;
+    for ( auto* reply : m_replies )
+    {
+        reply->disconnect( this );
+        if ( reply->isRunning() )
+        {
+            reply->abort();
+        }
+    }
+    emit finished( hasInternet );
 }
 
 QDebug&
@@ -23,8 +23,10 @@
 
 #include <QByteArray>
 #include <QDebug>
+#include <QHash>
 #include <QObject>
 #include <QUrl>
+#include <QVector>
 
 #include <chrono>
 #include <memory>
@@ -41,9 +43,23 @@ class DLLEXPORT RequestOptions
 public:
     using milliseconds = std::chrono::milliseconds;
 
+    /** @brief Flags for a request
+     *
+     * With UseCache, the response is stored in the on-disk HTTP cache,
+     * and a stored response is revalidated with the server (using
+     * ETag / Last-Modified) instead of being downloaded again.
+     * With CacheOnly, the request is answered from the cache only,
+     * without going to the network at all; this is useful as an
+     * offline fallback after a UseCache request failed.
+     * Requests without either flag never use the cache. There is
+     * only one cache, for the requests made from the main thread;
+     * requests from other threads ignore both flags.
+     */
     enum Flag
     {
         FollowRedirect = 0x1,
+        UseCache = 0x2,
+        CacheOnly = 0x4,
         FakeUserAgent = 0x100
     };
     Q_DECLARE_FLAGS( Flags, Flag )
@@ -64,6 +80,7 @@ public:
 
     bool hasTimeout() const { return m_timeout > milliseconds( 0 ); }
     auto timeout() const { return m_timeout; }
+    Flags flags() const { return m_flags; }
 
 private:
     Flags m_flags;
@@ -94,9 +111,19 @@ struct RequestStatus
 
 QDebug& operator<<( QDebug& s, const RequestStatus& e );
 
-class DLLEXPORT Manager : QObject
+/// @brief Statistics for all the requests sent to one host
+struct HostMetrics
+{
+    qint64 requests = 0;  ///< Completed requests (including failures)
+    qint64 failures = 0;  ///< Requests that completed with an error
+    qint64 bytesReceived = 0;
+    std::chrono::milliseconds totalLatency = std::chrono::milliseconds( 0 );  ///< Time from request to completion
+};
+
+class DLLEXPORT Manager : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY( bool hasInternet READ hasInternet NOTIFY hasInternetChanged FINAL )
 
     Manager();
 
@@ -124,17 +151,44 @@ public:
      *
      * Returns the data as a QByteArray, or an empty
      * array if any error occurred (or no data was returned).
+     *
+     * If @p options has the UseCache flag and the download fails,
+     * the last good copy from the cache is returned, if there is one.
      */
     QByteArray synchronousGet( const QUrl& url, const RequestOptions& options = RequestOptions() );
 
     /// @brief Set the URL which is used for the general "is there internet" check.
     void setCheckHasInternetUrl( const QUrl& url );
+    /** @brief Set the URLs which are used for the general "is there internet" check.
+     *
+     * All of the URLs are tried in parallel; if any of them
+     * returns data, there is internet.
+     */
+    void setCheckHasInternetUrl( const QVector< QUrl >& urls );
+    /** @brief Set how long the result of a connectivity check is re-used.
+     *
+     * Until @p ttl has passed, checkHasInternet() returns the
+     * result of the previous check instead of checking again.
+     * A change in network accessibility reported by Qt always
+     * starts a new check. The welcome module sets this from
+     * *internetCheckTtl* in welcome.conf.
+     */
+    void setCheckHasInternetTtl( std::chrono::seconds ttl );
     /** @brief Do an explicit check for internet connectivity.
      *
-     * This **may** do a ping to the configured check URL, but can also
-     * use other mechanisms.
+     * This **may** do a ping to the configured check URLs, but can also
+     * use other mechanisms, or re-use the result of a recent check.
+     * If an asynchronous check is running (started on another thread),
+     * waits for that check to complete.
      */
     bool checkHasInternet();
+    /** @brief Start a check for internet connectivity in the background.
+     *
+     * Returns immediately; when the check is done, hasInternetChanged()
+     * is emitted if the state has changed. Does nothing if a recent
+     * result is available or a check is already running.
+     */
+    void asynchronousCheckHasInternet();
     /** @brief Is there internet connectivity?
      *
      * This returns the result of the last explicit check, or if there
@@ -151,8 +205,27 @@ public:
      * The caller is responsible for cleaning up the reply (eventually).
      */
     QNetworkReply* asynchronousGet( const QUrl& url, const RequestOptions& options = RequestOptions() );
+    /** @brief Do a network request asynchronously.
+     *
+     * As above, but the caller builds the request, e.g. to add
+     * extra headers. The @p options are applied on top of it.
+     */
+    QNetworkReply* asynchronousGet( const QNetworkRequest& request, const RequestOptions& options = RequestOptions() );
+
+    /** @brief Statistics of requests done so far, by host name
+     *
+     * Requests from all threads are counted.
+     */
+    QHash< QString, HostMetrics > metrics() const;
+
+signals:
+    /// @brief Emitted when a connectivity check changes the result of hasInternet()
+    void hasInternetChanged( bool hasInternet );
 
 private:
+    /// @brief Re-checks connectivity when the main-thread NAM says it changed
+    void watchAccessibility();
+
     class Private;
     std::unique_ptr< Private > d;
 };
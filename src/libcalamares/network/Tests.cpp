@@ -18,13 +18,131 @@
 
 #include "Tests.h"
 
+#include "DownloadJob.h"
 #include "Manager.h"
 #include "utils/Logger.h"
 
 #include <QtTest/QtTest>
 
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+
+#include <memory>
+
 QTEST_GUILESS_MAIN( NetworkTests )
 
+/** @brief Serves one file over HTTP on localhost
+ *
+ * Depending on the mode, range requests are answered with
+ * the requested range (or a 416), or with the whole file; or
+ * all requests get a 404. The Range headers of the requests
+ * are recorded (an empty one for a request without a range).
+ */
+class FileServer : public QTcpServer
+{
+public:
+    enum class Mode
+    {
+        Ranges,
+        NoRanges,
+        NotFound
+    };
+
+    FileServer( const QByteArray& contents, Mode mode )
+        : m_contents( contents )
+        , m_mode( mode )
+    {
+        connect( this, &QTcpServer::newConnection, this, &FileServer::acceptConnections );
+        listen( QHostAddress::LocalHost );
+    }
+
+    QUrl url() const { return QUrl( QStringLiteral( "http://127.0.0.1:%1/file" ).arg( serverPort() ) ); }
+
+    QList< QByteArray > ranges;
+
+private:
+    void acceptConnections()
+    {
+        while ( QTcpSocket* socket = nextPendingConnection() )
+        {
+            auto buffer = std::make_shared< QByteArray >();
+            connect( socket, &QTcpSocket::readyRead, this, [ this, socket, buffer ]() {
+                buffer->append( socket->readAll() );
+                if ( buffer->contains( "\r\n\r\n" ) )
+                {
+                    respond( socket, *buffer );
+                }
+            } );
+            connect( socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater );
+        }
+    }
+
+    void respond( QTcpSocket* socket, const QByteArray& request )
+    {
+        QByteArray range;
+        for ( const auto& line : request.split( '\n' ) )
+        {
+            if ( line.toLower().startsWith( "range:" ) )
+            {
+                range = line.mid( 6 ).trimmed();
+            }
+        }
+        ranges.append( range );
+
+        const QByteArray size = QByteArray::number( m_contents.size() );
+        QByteArray status = "200 OK";
+        QByteArray headers;
+        QByteArray body = m_contents;
+        if ( m_mode == Mode::NotFound )
+        {
+            status = "404 Not Found";
+            body = "Not here";
+        }
+        else if ( m_mode == Mode::Ranges && range.startsWith( "bytes=" ) )
+        {
+            const int offset = range.mid( 6, range.indexOf( '-' ) - 6 ).toInt();
+            if ( offset >= m_contents.size() )
+            {
+                status = "416 Range Not Satisfiable";
+                headers = "Content-Range: bytes */" + size + "\r\n";
+                body.clear();
+            }
+            else
+            {
+                status = "206 Partial Content";
+                headers = "Content-Range: bytes " + QByteArray::number( offset ) + '-'
+                    + QByteArray::number( m_contents.size() - 1 ) + '/' + size + "\r\n";
+                body = m_contents.mid( offset );
+            }
+        }
+
+        socket->write( "HTTP/1.1 " + status + "\r\n" + headers
+                       + "Content-Length: " + QByteArray::number( body.size() )
+                       + "\r\nConnection: close\r\n\r\n" + body );
+        socket->disconnectFromHost();
+    }
+
+    QByteArray m_contents;
+    Mode m_mode;
+};
+
+/// @brief Writes @p data to @p fileName, returns @c true on success
+static bool
+writeFile( const QString& fileName, const QByteArray& data )
+{
+    QFile f( fileName );
+    return f.open( QIODevice::WriteOnly | QIODevice::Truncate ) && f.write( data ) == data.size();
+}
+
+/// @brief The contents of @p fileName
+static QByteArray
+readFile( const QString& fileName )
+{
+    QFile f( fileName );
+    return f.open( QIODevice::ReadOnly ) ? f.readAll() : QByteArray();
+}
+
 NetworkTests::NetworkTests() {}
 
 NetworkTests::~NetworkTests() {}
@@ -68,4 +186,142 @@ NetworkTests::testPing()
     {
         QVERIFY( canPing_www_kde_org );
     }
+
+    // Whatever the result, the ping was counted
+    const auto metrics = nam.metrics();
+    QVERIFY( metrics.contains( QStringLiteral( "www.kde.org" ) ) );
+    QVERIFY( metrics.value( QStringLiteral( "www.kde.org" ) ).requests > 0 );
+}
+
+void
+NetworkTests::testDownload()
+{
+    using namespace CalamaresUtils::Network;
+    Logger::setupLogLevel( Logger::LOGVERBOSE );
+
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+
+    const QByteArray contents( "Calamares download test\n" );
+    const QString source = dir.filePath( QStringLiteral( "source.txt" ) );
+    {
+        QFile f( source );
+        QVERIFY( f.open( QIODevice::WriteOnly ) );
+        f.write( contents );
+    }
+    const QByteArray checksum = QCryptographicHash::hash( contents, QCryptographicHash::Sha256 ).toHex();
+
+    // Good checksum, file arrives
+    {
+        const QString destination = dir.filePath( QStringLiteral( "sub/good.txt" ) );
+        DownloadJob job( { { QUrl::fromLocalFile( source ), destination, checksum } } );
+        QVERIFY( job.exec() );
+        QFile f( destination );
+        QVERIFY( f.open( QIODevice::ReadOnly ) );
+        QCOMPARE( f.readAll(), contents );
+        QVERIFY( !QFile::exists( destination + QStringLiteral( ".part" ) ) );
+    }
+    // Bad checksum, job fails and nothing is left behind
+    {
+        const QString destination = dir.filePath( QStringLiteral( "bad.txt" ) );
+        DownloadJob job( { { QUrl::fromLocalFile( source ), destination, QByteArray( "0123" ) } } );
+        QVERIFY( !job.exec() );
+        QVERIFY( !QFile::exists( destination ) );
+    }
+}
+
+void
+NetworkTests::testDownloadResume()
+{
+    using namespace CalamaresUtils::Network;
+    Logger::setupLogLevel( Logger::LOGVERBOSE );
+
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+
+    QByteArray contents;
+    for ( int i = 0; i < 100; ++i )
+    {
+        contents.append( "0123456789" );
+    }
+    const QString destination = dir.filePath( QStringLiteral( "resume.txt" ) );
+    const QString partName = destination + QStringLiteral( ".part" );
+
+    // Part of the file is there, the server sends the rest
+    {
+        FileServer server( contents, FileServer::Mode::Ranges );
+        QVERIFY( writeFile( partName, contents.left( 400 ) ) );
+        DownloadJob job( { { server.url(), destination } } );
+        QVERIFY( job.exec() );
+        QCOMPARE( server.ranges, QList< QByteArray > { "bytes=400-" } );
+        QCOMPARE( readFile( destination ), contents );
+        QVERIFY( !QFile::exists( partName ) );
+    }
+    // The server doesn't do ranges, so the .part is overwritten
+    {
+        FileServer server( contents, FileServer::Mode::NoRanges );
+        QVERIFY( writeFile( partName, QByteArray( 400, 'x' ) ) );
+        DownloadJob job( { { server.url(), destination } } );
+        QVERIFY( job.exec() );
+        QCOMPARE( server.ranges.count(), 1 );
+        QCOMPARE( readFile( destination ), contents );
+    }
+    // The whole file is there already (416)
+    {
+        FileServer server( contents, FileServer::Mode::Ranges );
+        QVERIFY( writeFile( partName, contents ) );
+        DownloadJob job( { { server.url(), destination } } );
+        QVERIFY( job.exec() );
+        QCOMPARE( server.ranges, QList< QByteArray > { "bytes=1000-" } );
+        QCOMPARE( readFile( destination ), contents );
+    }
+    // The .part is longer than the file (416), so it is junk: start over
+    {
+        FileServer server( contents, FileServer::Mode::Ranges );
+        QVERIFY( writeFile( partName, QByteArray( 1200, 'x' ) ) );
+        DownloadJob job( { { server.url(), destination } } );
+        QVERIFY( job.exec() );
+        QCOMPARE( server.ranges, ( QList< QByteArray > { "bytes=1200-", QByteArray() } ) );
+        QCOMPARE( readFile( destination ), contents );
+    }
+}
+
+void
+NetworkTests::testDownloadErrors()
+{
+    using namespace CalamaresUtils::Network;
+    Logger::setupLogLevel( Logger::LOGVERBOSE );
+
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+
+    const QByteArray contents( "Calamares download test\n" );
+    const QString destination = dir.filePath( QStringLiteral( "error.txt" ) );
+    const QString partName = destination + QStringLiteral( ".part" );
+
+    // A client error is not retried, the error page is not saved,
+    // and the .part (which can't be resumed) is removed.
+    {
+        FileServer server( contents, FileServer::Mode::NotFound );
+        QVERIFY( writeFile( partName, QByteArray( 10, 'x' ) ) );
+        DownloadJob job( { { server.url(), destination } } );
+        QVERIFY( !job.exec() );
+        QCOMPARE( server.ranges.count(), 1 );
+        QVERIFY( !QFile::exists( destination ) );
+        QVERIFY( !QFile::exists( partName ) );
+    }
+    // Writing fails (the device is full), which isn't retried either
+    {
+        if ( !QFile::exists( QStringLiteral( "/dev/full" ) ) )
+        {
+            QSKIP( "There is no /dev/full to write to." );
+        }
+        FileServer server( contents, FileServer::Mode::Ranges );
+        QVERIFY( QFile::link( QStringLiteral( "/dev/full" ), partName ) );
+        DownloadJob job( { { server.url(), destination } } );
+        QVERIFY( !job.exec() );
+        QCOMPARE( server.ranges.count(), 1 );
+        QVERIFY( !QFile::exists( destination ) );
+        QVERIFY( !QFileInfo( partName ).isSymLink() );
+    }
 }
@@ -33,6 +33,9 @@ private Q_SLOTS:
 
     void testInstance();
     void testPing();
+    void testDownload();
+    void testDownloadResume();
+    void testDownloadErrors();
 };
 
 #endif
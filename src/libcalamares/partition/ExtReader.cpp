@@ -0,0 +1,448 @@
+/* === This file is part of Calamares - <https://github.com/calamares> ===
+ *
+ *   Copyright 2020, agent <agent@local>
+ *
+ *   Calamares is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Calamares is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Calamares. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ExtReader.h"
+
+#include "utils/Logger.h"
+
+#include <QFile>
+#include <QVector>
+
+/* The on-disk layout of ext2/3/4 is described in the kernel documentation,
+ * Documentation/filesystems/ext4/ ; only the parts needed to find a file
+ * by name and read it are implemented here. Offsets are in bytes.
+ */
+
+namespace CalamaresUtils
+{
+namespace Partition
+{
+
+/// Files (and directories) larger than this are not read
+static constexpr qint64 maximumFileSize = 8 * 1024 * 1024;
+
+static constexpr quint32 rootInode = 2;
+
+// Incompatible features that change the layout in ways not handled here:
+// compression, journal device, meta_bg, dirdata
+static constexpr quint32 unsupportedIncompat = 0x0001 | 0x0008 | 0x0010 | 0x1000;
+static constexpr quint32 incompat64Bit = 0x0080;
+
+// Inode flags
+static constexpr quint32 inodeEncrypted = 0x00000800;
+static constexpr quint32 inodeExtents = 0x00080000;
+static constexpr quint32 inodeInlineData = 0x10000000;
+
+static constexpr quint16 modeTypeMask = 0xF000;
+static constexpr quint16 modeDirectory = 0x4000;
+static constexpr quint16 modeRegular = 0x8000;
+static constexpr quint16 modeSymlink = 0xA000;
+
+static inline quint32
+le16( const QByteArray& data, int offset )
+{
+    const auto* p = reinterpret_cast< const unsigned char* >( data.constData() ) + offset;
+    return quint32( p[ 0 ] ) | ( quint32( p[ 1 ] ) << 8 );
+}
+
+static inline quint32
+le32( const QByteArray& data, int offset )
+{
+    return le16( data, offset ) | ( le16( data, offset + 2 ) << 16 );
+}
+
+struct Inode
+{
+    quint32 mode = 0;
+    quint32 flags = 0;
+    qint64 size = 0;
+    QByteArray blocks;  ///< i_block, the extent tree root or block map
+};
+
+class ExtReader
+{
+public:
+    explicit ExtReader( QFile& device )
+        : m_device( device )
+    {
+    }
+
+    /// @brief Reads the superblock, returns false if it's not a usable ext filesystem
+    bool readSuperblock();
+    bool readInode( quint32 number, Inode& inode );
+    bool readContents( const Inode& inode, QByteArray& contents );
+    /** @brief Finds @p name in the @p directory
+     *
+     * Sets @p inode to the inode number of @p name, or 0 if it isn't there.
+     * Returns false if the directory can't be read.
+     */
+    bool lookup( const Inode& directory, const QByteArray& name, quint32& inode );
+
+private:
+    QByteArray readAt( qint64 offset, int length );
+    QByteArray readBlock( quint64 block ) { return readAt( qint64( block ) * m_blockSize, m_blockSize ); }
+    /// @brief Fills @p blocks (logical to physical) from an extent tree node
+    bool mapExtents( const QByteArray& node, int level, QVector< quint64 >& blocks );
+    /// @brief Fills @p blocks from an indirect block at @p level, which maps logical blocks from @p first
+    bool mapIndirect( quint64 block, int level, qint64 first, QVector< quint64 >& blocks );
+
+    QFile& m_device;
+    int m_blockSize = 0;
+    quint32 m_firstDataBlock = 0;
+    quint32 m_inodesCount = 0;
+    quint32 m_inodesPerGroup = 0;
+    int m_inodeSize = 128;
+    int m_descriptorSize = 32;
+};
+
+QByteArray
+ExtReader::readAt( qint64 offset, int length )
+{
+    if ( !m_device.seek( offset ) )
+    {
+        return QByteArray();
+    }
+    QByteArray data = m_device.read( length );
+    return data.size() == length ? data : QByteArray();
+}
+
+bool
+ExtReader::readSuperblock()
+{
+    const QByteArray sb = readAt( 1024, 1024 );
+    if ( sb.isEmpty() || le16( sb, 0x38 ) != 0xEF53 )
+    {
+        return false;
+    }
+
+    const quint32 logBlockSize = le32( sb, 0x18 );
+    const quint32 incompat = le32( sb, 0x60 );
+    if ( logBlockSize > 6 || ( incompat & unsupportedIncompat ) )
+    {
+        return false;
+    }
+
+    m_blockSize = 1024 << logBlockSize;
+    m_inodesCount = le32( sb, 0x00 );
+    m_firstDataBlock = le32( sb, 0x14 );
+    m_inodesPerGroup = le32( sb, 0x28 );
+    if ( le32( sb, 0x4C ) >= 1 )  // dynamic revision
+    {
+        m_inodeSize = int( le16( sb, 0x58 ) );
+    }
+    if ( incompat & incompat64Bit )
+    {
+        m_descriptorSize = int( le16( sb, 0xFE ) );
+    }
+    return m_inodesPerGroup > 0 && m_inodeSize >= 128 && m_inodeSize <= m_blockSize && m_descriptorSize >= 32
+        && m_descriptorSize <= m_blockSize;
+}
+
+bool
+ExtReader::readInode( quint32 number, Inode& inode )
+{
+    if ( number < 1 || number > m_inodesCount )
+    {
+        return false;
+    }
+    const quint32 group = ( number - 1 ) / m_inodesPerGroup;
+    const quint32 index = ( number - 1 ) % m_inodesPerGroup;
+
+    // The group descriptors follow the block with the superblock in it
+    const qint64 descriptorTable = qint64( m_firstDataBlock + 1 ) * m_blockSize;
+    const QByteArray descriptor = readAt( descriptorTable + qint64( group ) * m_descriptorSize, m_descriptorSize );
+    if ( descriptor.isEmpty() )
+    {
+        return false;
+    }
+    quint64 inodeTable = le32( descriptor, 0x08 );
+    if ( m_descriptorSize >= 64 )
+    {
+        inodeTable |= quint64( le32( descriptor, 0x28 ) ) << 32;
+    }
+
+    const QByteArray data = readAt( qint64( inodeTable ) * m_blockSize + qint64( index ) * m_inodeSize, 128 );
+    if ( data.isEmpty() )
+    {
+        return false;
+    }
+    inode.mode = le16( data, 0x00 );
+    inode.size = qint64( le32( data, 0x04 ) ) | ( qint64( le32( data, 0x6C ) ) << 32 );
+    inode.flags = le32( data, 0x20 );
+    inode.blocks = data.mid( 0x28, 60 );
+    return true;
+}
+
+bool
+ExtReader::mapExtents( const QByteArray& node, int level, QVector< quint64 >& blocks )
+{
+    // Header: magic, number of entries, max entries, depth; then 12-byte entries
+    if ( level > 5 || node.size() < 12 || le16( node, 0 ) != 0xF30A )
+    {
+        return false;
+    }
+    const int entries = int( le16( node, 2 ) );
+    const quint32 depth = le16( node, 6 );
+    if ( 12 + 12 * entries > node.size() )
+    {
+        return false;
+    }
+
+    for ( int i = 0; i < entries; ++i )
+    {
+        const int e = 12 + 12 * i;
+        if ( depth == 0 )
+        {
+            const quint32 logical = le32( node, e );
+            const quint32 length = le16( node, e + 4 );
+            const quint64 start = ( quint64( le16( node, e + 6 ) ) << 32 ) | le32( node, e + 8 );
+            if ( length > 32768 )
+            {
+                // Uninitialized extent, reads as zeroes
+                continue;
+            }
+            for ( quint32 j = 0; j < length && qint64( logical ) + j < blocks.count(); ++j )
+            {
+                blocks[ int( logical + j ) ] = start + j;
+            }
+        }
+        else
+        {
+            const quint64 child = ( quint64( le16( node, e + 8 ) ) << 32 ) | le32( node, e + 4 );
+            const QByteArray childNode = readBlock( child );
+            if ( childNode.isEmpty() || !mapExtents( childNode, level + 1, blocks ) )
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool
+ExtReader::mapIndirect( quint64 block, int level, qint64 first, QVector< quint64 >& blocks )
+{
+    if ( block == 0 || first >= blocks.count() )
+    {
+        // A hole, or beyond the end of the file
+        return true;
+    }
+    const QByteArray data = readBlock( block );
+    if ( data.isEmpty() )
+    {
+        return false;
+    }
+
+    const int pointers = m_blockSize / 4;
+    qint64 span = 1;  // Logical blocks per pointer
+    for ( int l = 1; l < level; ++l )
+    {
+        span *= pointers;
+    }
+    for ( int i = 0; i < pointers && first + i * span < blocks.count(); ++i )
+    {
+        const quint32 pointer = le32( data, 4 * i );
+        if ( level == 1 )
+        {
+            blocks[ int( first + i ) ] = pointer;
+        }
+        else if ( !mapIndirect( pointer, level - 1, first + i * span, blocks ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+ExtReader::readContents( const Inode& inode, QByteArray& contents )
+{
+    if ( inode.size < 0 || inode.size > maximumFileSize || ( inode.flags & inodeEncrypted ) )
+    {
+        return false;
+    }
+    if ( inode.flags & inodeInlineData )
+    {
+        // Small files live in i_block; larger ones continue in an extended
+        // attribute, which is not supported here.
+        if ( inode.size > inode.blocks.size() )
+        {
+            return false;
+        }
+        contents = inode.blocks.left( int( inode.size ) );
+        return true;
+    }
+
+    // Physical block for each logical block of the file; 0 for a hole
+    QVector< quint64 > blocks( int( ( inode.size + m_blockSize - 1 ) / m_blockSize ), 0 );
+    if ( inode.flags & inodeExtents )
+    {
+        if ( !mapExtents( inode.blocks, 0, blocks ) )
+        {
+            return false;
+        }
+    }
+    else
+    {
+        // 12 direct blocks, then single, double and triple indirect blocks
+        const qint64 pointers = m_blockSize / 4;
+        for ( int i = 0; i < 12 && i < blocks.count(); ++i )
+        {
+            blocks[ i ] = le32( inode.blocks, 4 * i );
+        }
+        if ( !mapIndirect( le32( inode.blocks, 48 ), 1, 12, blocks )
+             || !mapIndirect( le32( inode.blocks, 52 ), 2, 12 + pointers, blocks )
+             || !mapIndirect( le32( inode.blocks, 56 ), 3, 12 + pointers + pointers * pointers, blocks ) )
+        {
+            return false;
+        }
+    }
+
+    contents.clear();
+    contents.reserve( blocks.count() * m_blockSize );
+    for ( quint64 block : blocks )
+    {
+        if ( block == 0 )
+        {
+            contents.append( QByteArray( m_blockSize, '\0' ) );
+        }
+        else
+        {
+            const QByteArray data = readBlock( block );
+            if ( data.isEmpty() )
+            {
+                return false;
+            }
+            contents.append( data );
+        }
+    }
+    contents.truncate( int( inode.size ) );
+    return true;
+}
+
+bool
+ExtReader::lookup( const Inode& directory, const QByteArray& name, quint32& inode )
+{
+    inode = 0;
+    QByteArray entries;
+    if ( !readContents( directory, entries ) )
+    {
+        return false;
+    }
+
+    // Directory entries are: inode, record length, name length, file type, name.
+    // Hashed (htree) directories can be read the same way, since their
+    // index blocks look like empty entries to this.
+    int offset = 0;
+    while ( offset + 8 <= entries.size() )
+    {
+        const quint32 number = le32( entries, offset );
+        const int recordLength = int( le16( entries, offset + 4 ) );
+        const int nameLength = int( quint8( entries.at( offset + 6 ) ) );
+        if ( recordLength < 8 || offset + recordLength > entries.size() || 8 + nameLength > recordLength )
+        {
+            cWarning() << "Corrupt directory entry at offset" << offset;
+            return false;
+        }
+        if ( number != 0 && nameLength == name.size() && entries.mid( offset + 8, nameLength ) == name )
+        {
+            inode = number;
+            return true;
+        }
+        offset += recordLength;
+    }
+    return true;
+}
+
+QByteArray
+readExtFile( const QString& devicePath, const QString& fileName, ExtReadResult* result )
+{
+    ExtReadResult dummy;
+    ExtReadResult& r = result ? *result : dummy;
+    r = ExtReadResult::Unreadable;
+
+    QFile device( devicePath );
+    if ( !device.open( QIODevice::ReadOnly ) )
+    {
+        cWarning() << "Could not open" << devicePath << "for reading.";
+        return QByteArray();
+    }
+
+    ExtReader reader( device );
+    if ( !reader.readSuperblock() )
+    {
+        cDebug() << devicePath << "is not a supported ext filesystem.";
+        return QByteArray();
+    }
+
+    quint32 number = rootInode;
+    Inode inode;
+    for ( const QString& component : fileName.split( '/', QString::SkipEmptyParts ) )
+    {
+        if ( !reader.readInode( number, inode ) )
+        {
+            return QByteArray();
+        }
+        if ( ( inode.mode & modeTypeMask ) == modeSymlink )
+        {
+            cDebug() << "Symlink on the way to" << fileName << "on" << devicePath;
+            return QByteArray();
+        }
+        if ( ( inode.mode & modeTypeMask ) != modeDirectory )
+        {
+            cDebug() << "No" << fileName << "on" << devicePath;
+            r = ExtReadResult::NotFound;
+            return QByteArray();
+        }
+        if ( !reader.lookup( inode, component.toLocal8Bit(), number ) )
+        {
+            return QByteArray();
+        }
+        if ( !number )
+        {
+            cDebug() << "No" << fileName << "on" << devicePath;
+            r = ExtReadResult::NotFound;
+            return QByteArray();
+        }
+    }
+
+    if ( !reader.readInode( number, inode ) )
+    {
+        return QByteArray();
+    }
+    const auto type = inode.mode & modeTypeMask;
+    if ( type != modeRegular )
+    {
+        cDebug() << fileName << "on" << devicePath << "is not a regular file.";
+        // A symlink might lead to a file, which mounting would find
+        r = type == modeSymlink ? ExtReadResult::Unreadable : ExtReadResult::NotFound;
+        return QByteArray();
+    }
+    QByteArray contents;
+    if ( !reader.readContents( inode, contents ) )
+    {
+        cDebug() << "Could not read" << fileName << "from" << devicePath;
+        return QByteArray();
+    }
+
+    r = ExtReadResult::Ok;
+    return contents;
+}
+
+}  // namespace Partition
+}  // namespace CalamaresUtils
@@ -0,0 +1,62 @@
+/* === This file is part of Calamares - <https://github.com/calamares> ===
+ *
+ *   Copyright 2020, agent <agent@local>
+ *
+ *   Calamares is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Calamares is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Calamares. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PARTITION_EXTREADER_H
+#define PARTITION_EXTREADER_H
+
+#include "DllMacro.h"
+
+#include <QByteArray>
+#include <QString>
+
+namespace CalamaresUtils
+{
+namespace Partition
+{
+
+/// @brief How readExtFile() went
+enum class ExtReadResult
+{
+    Ok,  ///< The file was read
+    NotFound,  ///< The filesystem was read, and there is no such file in it
+    Unreadable  ///< The filesystem (or the file) can't be read without mounting
+};
+
+/** @brief Reads a (small) file from an ext2, ext3 or ext4 filesystem without mounting it
+ *
+ * The filesystem on @p devicePath (a block device, or an image file) is
+ * read directly, and @p fileName (an absolute path within the filesystem,
+ * e.g. "/etc/fstab") is looked up in it. This is meant for configuration
+ * files of other installed systems: the journal is not replayed (just
+ * like a mount with "noload"), symlinks are not followed and files
+ * larger than a few MiB are not read.
+ *
+ * If @p result is not nullptr, it is set to how the read went. A file
+ * that does not exist (or is not a regular file) is NotFound, and
+ * mounting won't find it either. Unreadable is for everything that
+ * isn't handled here (e.g. the filesystem is not ext2/3/4, it uses
+ * features that are not supported, or there is a symlink in the way);
+ * in that case, mounting the filesystem is the way to go.
+ */
+DLLEXPORT QByteArray
+readExtFile( const QString& devicePath, const QString& fileName, ExtReadResult* result = nullptr );
+
+}  // namespace Partition
+}  // namespace CalamaresUtils
+
+#endif
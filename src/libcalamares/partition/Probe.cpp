@@ -0,0 +1,125 @@
+/* === This file is part of Calamares - <https://github.com/calamares> ===
+ *
+ *   Copyright 2020, agent <agent@local>
+ *
+ *   Calamares is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Calamares is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Calamares. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Probe.h"
+
+#include "utils/Logger.h"
+
+#include <QFile>
+
+#include <cstring>
+
+namespace CalamaresUtils
+{
+namespace Partition
+{
+
+/// @brief Does @p data contain @p magic (of length @p size) at @p offset ?
+static bool
+hasMagic( const QByteArray& data, int offset, const char* magic, int size )
+{
+    return ( data.size() >= offset + size ) && ( std::memcmp( data.constData() + offset, magic, size_t( size ) ) == 0 );
+}
+
+/// @brief Little-endian unsigned 32-bit value at @p offset in @p data
+static quint32
+le32( const QByteArray& data, int offset )
+{
+    const auto* p = reinterpret_cast< const unsigned char* >( data.constData() ) + offset;
+    return quint32( p[ 0 ] ) | ( quint32( p[ 1 ] ) << 8 ) | ( quint32( p[ 2 ] ) << 16 ) | ( quint32( p[ 3 ] ) << 24 );
+}
+
+/** @brief Tells ext2, ext3 and ext4 apart, like blkid does
+ *
+ * They share a superblock (at 1024 bytes), so it depends on the features:
+ * ext3 has a journal, and ext4 has features that ext3 doesn't support.
+ */
+static QString
+extType( const QByteArray& data )
+{
+    constexpr int superblock = 1024;
+    constexpr quint32 compatHasJournal = 0x0004;
+    // Incompatible features that ext3 does support: filetype, recover, meta_bg
+    constexpr quint32 ext3Incompat = 0x0002 | 0x0004 | 0x0010;
+    // Read-only features that ext3 does support: sparse_super, large_file, btree_dir
+    constexpr quint32 ext3ROCompat = 0x0001 | 0x0002 | 0x0004;
+    constexpr quint32 incompatJournalDevice = 0x0008;
+
+    const quint32 compat = le32( data, superblock + 0x5C );
+    const quint32 incompat = le32( data, superblock + 0x60 );
+    const quint32 roCompat = le32( data, superblock + 0x64 );
+
+    if ( incompat & incompatJournalDevice )
+    {
+        // An external journal, not a filesystem
+        return QString();
+    }
+    if ( ( incompat & ~ext3Incompat ) || ( roCompat & ~ext3ROCompat ) )
+    {
+        return QStringLiteral( "ext4" );
+    }
+    return ( compat & compatHasJournal ) ? QStringLiteral( "ext3" ) : QStringLiteral( "ext2" );
+}
+
+QString
+probeFileSystemTypeFromData( const QByteArray& data )
+{
+    // The primary volume descriptor is in sector 16 (of 2048 bytes)
+    if ( hasMagic( data, 32769, "CD001", 5 ) )
+    {
+        return QStringLiteral( "iso9660" );
+    }
+    // The ext superblock is at 1024, the magic 0xEF53 (little-endian) at 56 in it
+    if ( hasMagic( data, 1024 + 56, "\x53\xEF", 2 ) && ( data.size() >= 1024 + 0x68 ) )
+    {
+        return extType( data );
+    }
+    // The btrfs superblock is at 64KiB, the magic at 64 in it
+    if ( hasMagic( data, 65536 + 64, "_BHRfS_M", 8 ) )
+    {
+        return QStringLiteral( "btrfs" );
+    }
+    if ( hasMagic( data, 0, "XFSB", 4 ) )
+    {
+        return QStringLiteral( "xfs" );
+    }
+    // The swap signature is at the end of the first page, and page size varies
+    for ( int pageSize = 4096; pageSize <= 65536; pageSize *= 2 )
+    {
+        if ( hasMagic( data, pageSize - 10, "SWAPSPACE2", 10 ) || hasMagic( data, pageSize - 10, "SWAP-SPACE", 10 ) )
+        {
+            return QStringLiteral( "swap" );
+        }
+    }
+    return QString();
+}
+
+QString
+probeFileSystemType( const QString& devicePath )
+{
+    QFile device( devicePath );
+    if ( !device.open( QIODevice::ReadOnly ) )
+    {
+        cWarning() << "Could not open" << devicePath << "to probe the filesystem.";
+        return QString();
+    }
+    return probeFileSystemTypeFromData( device.read( probeSize ) );
+}
+
+}  // namespace Partition
+}  // namespace CalamaresUtils
@@ -0,0 +1,66 @@
+/* === This file is part of Calamares - <https://github.com/calamares> ===
+ *
+ *   Copyright 2020, agent <agent@local>
+ *
+ *   Calamares is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Calamares is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Calamares. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Finding out what filesystem is on a device, without running blkid(8).
+ *
+ * Only the handful of filesystems that Calamares needs to know about
+ * before anything is mounted are recognized: the signatures are read
+ * directly from the first bytes of the device.
+ */
+
+#ifndef PARTITION_PROBE_H
+#define PARTITION_PROBE_H
+
+#include "DllMacro.h"
+
+#include <QByteArray>
+#include <QString>
+
+namespace CalamaresUtils
+{
+namespace Partition
+{
+
+/** @brief The number of bytes at the start of a device that probing looks at
+ *
+ * The btrfs superblock, at 64KiB, is the furthest from the start.
+ */
+constexpr int probeSize = 65536 + 4096;
+
+/** @brief Name of the filesystem found in @p data
+ *
+ * The @p data is the start of a device (or image file); it should be
+ * probeSize bytes long, but may be shorter (e.g. for a small file). The
+ * names are those of blkid(8): "iso9660", "ext2", "ext3", "ext4",
+ * "btrfs", "xfs" and "swap". Returns an empty string for anything
+ * else (unrecognized, or too short).
+ */
+DLLEXPORT QString probeFileSystemTypeFromData( const QByteArray& data );
+
+/** @brief Name of the filesystem on the device (or file) @p devicePath
+ *
+ * Reads the start of the device once and calls probeFileSystemTypeFromData().
+ * Returns an empty string if the device cannot be read.
+ */
+DLLEXPORT QString probeFileSystemType( const QString& devicePath );
+
+}  // namespace Partition
+}  // namespace CalamaresUtils
+
+#endif
@@ -18,7 +18,9 @@
 
 #include "Tests.h"
 
+#include "ExtReader.h"
 #include "PartitionSize.h"
+#include "Probe.h"
 
 using SizeUnit = CalamaresUtils::Partition::SizeUnit;
 using PartitionSize = CalamaresUtils::Partition::PartitionSize;
@@ -27,6 +29,10 @@ Q_DECLARE_METATYPE( SizeUnit )
 
 #include "utils/Logger.h"
 
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
 #include <QtTest/QtTest>
 
 QTEST_GUILESS_MAIN( PartitionSizeTests )
@@ -140,3 +146,145 @@ PartitionSizeTests::testUnitNormalisation()
 
     QCOMPARE( PartitionSize( v, u1 ).toBytes(), static_cast< qint64 >( bytes ) );
 }
+
+/// @brief An empty device start with @p magic at @p offset
+static QByteArray
+deviceData( int offset, const QByteArray& magic )
+{
+    QByteArray data( CalamaresUtils::Partition::probeSize, '\0' );
+    data.replace( offset, magic.size(), magic );
+    return data;
+}
+
+/// @brief An ext superblock with the given feature flags
+static QByteArray
+extData( char compat, char incompat, char roCompat )
+{
+    QByteArray data = deviceData( 1024 + 56, QByteArray( "\x53\xEF" ) );
+    data[ 1024 + 0x5C ] = compat;
+    data[ 1024 + 0x60 ] = incompat;
+    data[ 1024 + 0x64 ] = roCompat;
+    return data;
+}
+
+void
+PartitionSizeTests::testProbe_data()
+{
+    QTest::addColumn< QByteArray >( "data" );
+    QTest::addColumn< QString >( "fs" );
+
+    QTest::newRow( "empty" ) << QByteArray() << QString();
+    QTest::newRow( "zeroes" ) << QByteArray( CalamaresUtils::Partition::probeSize, '\0' ) << QString();
+    QTest::newRow( "iso9660" ) << deviceData( 32769, "CD001" ) << QStringLiteral( "iso9660" );
+    QTest::newRow( "iso-short" ) << deviceData( 32769, "CD001" ).left( 32772 ) << QString();
+    QTest::newRow( "ext2" ) << extData( 0, 0x02, 0x01 ) << QStringLiteral( "ext2" );
+    QTest::newRow( "ext3" ) << extData( 0x04, 0x02, 0x03 ) << QStringLiteral( "ext3" );
+    // extents (0x40) in incompat, or huge_file (0x08) in ro_compat
+    QTest::newRow( "ext4" ) << extData( 0x04, 0x42, 0x01 ) << QStringLiteral( "ext4" );
+    QTest::newRow( "ext4-ro" ) << extData( 0x04, 0x02, 0x08 ) << QStringLiteral( "ext4" );
+    QTest::newRow( "jbd" ) << extData( 0, 0x08, 0 ) << QString();
+    QTest::newRow( "btrfs" ) << deviceData( 65536 + 64, "_BHRfS_M" ) << QStringLiteral( "btrfs" );
+    QTest::newRow( "xfs" ) << deviceData( 0, "XFSB" ) << QStringLiteral( "xfs" );
+    QTest::newRow( "swap" ) << deviceData( 4086, "SWAPSPACE2" ) << QStringLiteral( "swap" );
+    QTest::newRow( "swap16k" ) << deviceData( 16374, "SWAPSPACE2" ) << QStringLiteral( "swap" );
+    QTest::newRow( "swap-odd" ) << deviceData( 4000, "SWAPSPACE2" ) << QString();
+}
+
+void
+PartitionSizeTests::testProbe()
+{
+    QFETCH( QByteArray, data );
+    QFETCH( QString, fs );
+
+    QCOMPARE( CalamaresUtils::Partition::probeFileSystemTypeFromData( data ), fs );
+
+    QTemporaryFile f;
+    QVERIFY( f.open() );
+    QCOMPARE( f.write( data ), data.size() );
+    f.close();
+    QCOMPARE( CalamaresUtils::Partition::probeFileSystemType( f.fileName() ), fs );
+}
+
+void
+PartitionSizeTests::testExtReader_data()
+{
+    QTest::addColumn< QStringList >( "options" );
+
+    QTest::newRow( "ext2" ) << QStringList { "-t", "ext2", "-b", "1024" };
+    QTest::newRow( "ext3" ) << QStringList { "-t", "ext3" };
+    QTest::newRow( "ext4" ) << QStringList { "-t", "ext4" };
+    QTest::newRow( "ext4-64bit" ) << QStringList { "-t", "ext4", "-O", "64bit", "-b", "2048" };
+}
+
+void
+PartitionSizeTests::testExtReader()
+{
+    QFETCH( QStringList, options );
+
+    const QString mke2fs = QStandardPaths::findExecutable( "mke2fs", { "/sbin", "/usr/sbin", "/usr/bin" } );
+    if ( mke2fs.isEmpty() )
+    {
+        QSKIP( "No mke2fs available" );
+    }
+
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    QVERIFY( QDir( dir.path() ).mkpath( "root/etc" ) );
+
+    const QByteArray fstab( "UUID=0123-4567 / ext4 defaults 0 1\n/dev/sda2 /home ext4 defaults 0 2\n" );
+    QFile fstabFile( dir.filePath( "root/etc/fstab" ) );
+    QVERIFY( fstabFile.open( QIODevice::WriteOnly ) );
+    fstabFile.write( fstab );
+    fstabFile.close();
+    // Enough files in etc/ that the directory is hashed (and not a single block)
+    for ( int i = 0; i < 500; ++i )
+    {
+        QFile f( dir.filePath( QString( "root/etc/file%1" ).arg( i ) ) );
+        QVERIFY( f.open( QIODevice::WriteOnly ) );
+    }
+    // A file larger than the direct blocks (with 1KiB blocks)
+    QByteArray big;
+    for ( int i = 0; big.size() < 300000; ++i )
+    {
+        big.append( QByteArray::number( i ) );
+    }
+    QFile bigFile( dir.filePath( "root/etc/big" ) );
+    QVERIFY( bigFile.open( QIODevice::WriteOnly ) );
+    bigFile.write( big );
+    bigFile.close();
+    QVERIFY( QFile::link( "fstab", dir.filePath( "root/etc/link" ) ) );
+
+    const QString image = dir.filePath( "image" );
+    QProcess p;
+    p.start( mke2fs, QStringList { "-q", "-F" } << options << "-d" << dir.filePath( "root" ) << image << "16M" );
+    QVERIFY( p.waitForFinished() );
+    if ( p.exitCode() != 0 )
+    {
+        QSKIP( "mke2fs cannot create the image (too old for -d?)" );
+    }
+
+    using CalamaresUtils::Partition::ExtReadResult;
+    ExtReadResult result = ExtReadResult::Unreadable;
+    QCOMPARE( CalamaresUtils::Partition::readExtFile( image, "/etc/fstab", &result ), fstab );
+    QCOMPARE( result, ExtReadResult::Ok );
+    QCOMPARE( CalamaresUtils::Partition::readExtFile( image, "/etc/big", &result ), big );
+    QCOMPARE( result, ExtReadResult::Ok );
+    QCOMPARE( CalamaresUtils::Partition::readExtFile( image, "/etc/file499", &result ), QByteArray() );
+    QCOMPARE( result, ExtReadResult::Ok );
+
+    // Missing, or not a file: mounting won't help
+    (void)CalamaresUtils::Partition::readExtFile( image, "/etc/nothere", &result );
+    QCOMPARE( result, ExtReadResult::NotFound );
+    (void)CalamaresUtils::Partition::readExtFile( image, "/nothere/fstab", &result );
+    QCOMPARE( result, ExtReadResult::NotFound );
+    (void)CalamaresUtils::Partition::readExtFile( image, "/etc/big/fstab", &result );
+    QCOMPARE( result, ExtReadResult::NotFound );
+    (void)CalamaresUtils::Partition::readExtFile( image, "/etc", &result );
+    QCOMPARE( result, ExtReadResult::NotFound );
+    // Symlinks are not followed, but mounting would
+    (void)CalamaresUtils::Partition::readExtFile( image, "/etc/link", &result );
+    QCOMPARE( result, ExtReadResult::Unreadable );
+    // Not an ext filesystem
+    (void)CalamaresUtils::Partition::readExtFile( fstabFile.fileName(), "/etc/fstab", &result );
+    QCOMPARE( result, ExtReadResult::Unreadable );
+}
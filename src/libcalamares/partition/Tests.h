@@ -36,6 +36,12 @@ private Q_SLOTS:
 
     void testUnitNormalisation_data();
     void testUnitNormalisation();
+
+    void testProbe_data();
+    void testProbe();
+
+    void testExtReader_data();
+    void testExtReader();
 };
 
 #endif
@@ -201,6 +201,28 @@ appLogDir()
 }
 
 
+QDir
+appCacheDir( bool& ok )
+{
+    QString path = QStandardPaths::writableLocation( QStandardPaths::CacheLocation );
+    if ( !path.isEmpty() )
+    {
+        QDir dir( path + QStringLiteral( "/cache" ) );
+        if ( isWritableDir( dir ) )
+        {
+            ok = true;
+            return dir;
+        }
+    }
+
+    // There is deliberately no fallback to the (shared) temp dir:
+    // other users could plant entries there before Calamares starts.
+    cerr << "warning: Could not find a standard writable location for cache dir, not caching on disk\n";
+    ok = false;
+    return QDir();
+}
+
+
 void
 setQmlModulesDir( const QDir& dir )
 {
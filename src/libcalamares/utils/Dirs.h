@@ -45,6 +45,14 @@ DLLEXPORT QDir appDataDir();
  */
 DLLEXPORT QDir appLogDir();
 
+/**
+ * @brief appCacheDir returns the directory for cached data (e.g. rendered images).
+ * Defaults to the subdirectory *cache* of QStandardPaths::CacheLocation
+ * (usually ~/.cache/Calamares/cache). Sets @p ok to @c false if there
+ * is no writable cache directory; callers should not cache on disk then.
+ */
+DLLEXPORT QDir appCacheDir( bool& ok );
+
 /**
  * @brief systemLibDir returns the system's lib directory.
  * Defaults to CMAKE_INSTALL_FULL_LIBDIR (usually /usr/lib64 or /usr/lib).
@@ -26,6 +26,7 @@
 #include "utils/ImageRegistry.h"
 #include "utils/Logger.h"
 #include "utils/NamedEnum.h"
+#include "utils/Variant.h"
 #include "utils/Yaml.h"
 
 #include <QDir>
@@ -35,6 +36,7 @@
 #include <QVariantMap>
 
 #include <functional>
+#include <limits>
 
 #ifdef WITH_KOSRelease
 #include <KMacroExpander>
@@ -538,6 +540,19 @@ Branding::initSimpleSettings( const YAML::Node& doc )
     {
         m_windowHeight = WindowDimension( CalamaresUtils::windowPreferredHeight, WindowDimensionUnit::Pixies );
     }
+
+    if ( doc[ "imageCache" ].IsMap() )
+    {
+        const QVariantMap imageCache = CalamaresUtils::yamlMapToVariant( doc[ "imageCache" ] );
+        const qint64 memory = CalamaresUtils::getInteger( imageCache, QStringLiteral( "memory" ), 0 );
+        if ( memory > 0 )
+        {
+            const int limit = int( qMin( memory, qint64( std::numeric_limits< int >::max() ) ) );
+            ImageRegistry::instance()->setCacheLimit( limit );
+        }
+        ImageRegistry::instance()->setDiskCacheEnabled(
+            CalamaresUtils::getBool( imageCache, QStringLiteral( "disk" ), true ) );
+    }
 }
 
 
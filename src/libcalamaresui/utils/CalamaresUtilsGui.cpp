@@ -139,6 +139,13 @@ defaultPixmap( ImageType type, ImageMode mode, const QSize& size )
 
 QPixmap
 createRoundedImage( const QPixmap& pixmap, const QSize& size, float frameWidthPct )
+{
+    return QPixmap::fromImage( createRoundedImage( pixmap.toImage(), size, frameWidthPct ) );
+}
+
+
+QImage
+createRoundedImage( const QImage& image, const QSize& size, float frameWidthPct )
 {
     int height;
     int width;
@@ -150,22 +157,22 @@ createRoundedImage( const QPixmap& pixmap, const QSize& size, float frameWidthPc
     }
     else
     {
-        height = pixmap.height();
-        width = pixmap.width();
+        height = image.height();
+        width = image.width();
     }
 
     if ( !height || !width )
     {
-        return QPixmap();
+        return QImage();
     }
 
-    QPixmap scaledAvatar = pixmap.scaled( width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+    QImage scaledAvatar = image.scaled( width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
     if ( frameWidthPct == 0.00f )
     {
         return scaledAvatar;
     }
 
-    QPixmap frame( width, height );
+    QImage frame( width, height, QImage::Format_ARGB32_Premultiplied );
     frame.fill( Qt::transparent );
 
     QPainter painter( &frame );
@@ -22,6 +22,7 @@
 
 #include "DllMacro.h"
 
+#include <QImage>
 #include <QObject>
 #include <QPixmap>
 #include <QSize>
@@ -96,6 +97,14 @@ UIDLLEXPORT QPixmap defaultPixmap( ImageType type,
  * This one is currently unused.
  */
 UIDLLEXPORT QPixmap createRoundedImage( const QPixmap& avatar, const QSize& size, float frameWidthPct = 0.20f );
+/**
+ * @brief createRoundedImage returns a rounded version of an image.
+ *
+ * This is the same as the QPixmap overload, but it does not need
+ * the GUI thread, so it can be used while preparing images in
+ * the background.
+ */
+UIDLLEXPORT QImage createRoundedImage( const QImage& avatar, const QSize& size, float frameWidthPct = 0.20f );
 
 /**
  * @brief unmarginLayout recursively walks the QLayout tree and removes all margins.
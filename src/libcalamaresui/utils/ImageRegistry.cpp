@@ -25,11 +25,218 @@
 
 #include "ImageRegistry.h"
 
+#include "CalamaresVersion.h"
+
+#include "utils/Dirs.h"
+#include "utils/Logger.h"
+
+#include <QCache>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QIcon>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QPainter>
+#include <QSaveFile>
 #include <QSvgRenderer>
+#include <QThread>
 
-static QHash< QString, QHash< int, QHash< qint64, QPixmap > > > s_cache;
+#include <cstring>
+
+namespace
+{
+/// @brief Everything that distinguishes one rendering of an image from another
+struct ImageKey
+{
+    QString image;
+    QSize size;
+    int mode;
+    int opacity;  ///< Opacity in thousandths
+    QRgb tint;
+
+    ImageKey( const QString& i, const QSize& s, CalamaresUtils::ImageMode m, qreal o, const QColor& t )
+        : image( i )
+        , size( s )
+        , mode( m )
+        , opacity( qRound( o * 1000.0 ) )
+        , tint( t.rgba() )
+    {
+    }
+
+    bool operator==( const ImageKey& other ) const
+    {
+        return image == other.image && size == other.size && mode == other.mode && opacity == other.opacity
+            && tint == other.tint;
+    }
+};
+
+uint
+qHash( const ImageKey& key, uint seed = 0 )
+{
+    uint h = ::qHash( key.image, seed );
+    for ( uint v : { uint( key.size.width() ),
+                     uint( key.size.height() ),
+                     uint( key.mode ),
+                     uint( key.opacity ),
+                     uint( key.tint ) } )
+    {
+        h ^= v + 0x9e3779b9 + ( h << 6 ) + ( h >> 2 );
+    }
+    return h;
+}
+
+/// @brief The cost of @p image in the cache, in KiB
+int
+imageCost( const QImage& image )
+{
+    return qMax( 1, int( qint64( image.bytesPerLine() ) * image.height() / 1024 ) );
+}
+
+/// @brief The cost of @p pixmap in the cache, in KiB
+int
+pixmapCost( const QPixmap& pixmap )
+{
+    return qMax( 1, int( qint64( pixmap.width() ) * pixmap.height() * pixmap.depth() / 8 / 1024 ) );
+}
+
+/** @brief Header of an image in the on-disk cache
+ *
+ * The header is followed by the raw pixel data, bytesPerLine * height
+ * bytes of it, so that the file can be mapped and used directly.
+ */
+struct DiskImageHeader
+{
+    char magic[ 4 ];
+    quint32 version;
+    qint32 width;
+    qint32 height;
+    qint32 bytesPerLine;
+    qint32 format;
+    quint64 dataSize;
+};
+static_assert( sizeof( DiskImageHeader ) == 32, "Disk image header must keep pixel data aligned" );
+
+static constexpr char s_diskMagic[ 4 ] = { 'C', 'I', 'M', 'G' };
+static constexpr quint32 s_diskVersion = 1;
+
+/** @brief Filename of the rendering @p key in the on-disk cache
+ *
+ * The name is a hash of the path, modification time and size of the
+ * source image, and of the rendering parameters, so changed images
+ * don't get a stale rendering (without reading the whole source
+ * every time). Images in resources have no modification time, so the
+ * Calamares version goes into the hash as well. Returns an empty string
+ * if the source doesn't exist or there is no cache directory.
+ */
+QString
+diskCacheName( const ImageKey& key )
+{
+    static const QString cacheDir = []() {
+        bool ok = false;
+        QDir dir = CalamaresUtils::appCacheDir( ok );
+        if ( ok && dir.mkpath( QStringLiteral( "images" ) ) )
+        {
+            return dir.absoluteFilePath( QStringLiteral( "images" ) ) + '/';
+        }
+        return QString();
+    }();
+    if ( cacheDir.isEmpty() )
+    {
+        return QString();
+    }
+
+    const QFileInfo source( key.image );
+    if ( !source.isFile() )
+    {
+        return QString();
+    }
+
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+    hash.addData( QByteArrayLiteral( CALAMARES_VERSION ) );
+    hash.addData( source.absoluteFilePath().toUtf8() );
+    const qint64 stat[] = { source.lastModified().toMSecsSinceEpoch(), source.size() };
+    hash.addData( reinterpret_cast< const char* >( stat ), sizeof( stat ) );
+    const qint32 parameters[] = { key.size.width(), key.size.height(), key.mode, key.opacity, qint32( key.tint ) };
+    hash.addData( reinterpret_cast< const char* >( parameters ), sizeof( parameters ) );
+    return cacheDir + QString::fromLatin1( hash.result().toHex() );
+}
+
+/** @brief Maps the cached image @p fileName into memory
+ *
+ * The returned image uses the mapped file as pixel data; the file is
+ * closed (and unmapped) when the last copy of the image is gone.
+ * Returns a null image if the file doesn't exist or is not valid.
+ */
+QImage
+loadFromDisk( const QString& fileName )
+{
+    QFile* f = new QFile( fileName );
+    if ( !f->open( QIODevice::ReadOnly ) || f->size() < qint64( sizeof( DiskImageHeader ) ) )
+    {
+        delete f;
+        return QImage();
+    }
+
+    const uchar* data = f->map( 0, f->size() );
+    const DiskImageHeader* header = reinterpret_cast< const DiskImageHeader* >( data );
+    if ( !data || memcmp( header->magic, s_diskMagic, sizeof( s_diskMagic ) ) != 0
+         || header->version != s_diskVersion || header->width <= 0 || header->height <= 0
+         || header->bytesPerLine < header->width || header->format <= QImage::Format_Invalid
+         || header->format >= QImage::NImageFormats
+         || header->dataSize != quint64( header->bytesPerLine ) * quint64( header->height )
+         || quint64( f->size() ) != sizeof( DiskImageHeader ) + header->dataSize )
+    {
+        cWarning() << "Ignoring invalid cached image" << fileName;
+        delete f;
+        return QImage();
+    }
+
+    return QImage( data + sizeof( DiskImageHeader ),
+                   header->width,
+                   header->height,
+                   header->bytesPerLine,
+                   QImage::Format( header->format ),
+                   []( void* file ) { delete static_cast< QFile* >( file ); },
+                   f );
+}
+
+/// @brief Stores @p image in the on-disk cache as @p fileName
+void
+saveToDisk( const QString& fileName, const QImage& image )
+{
+    DiskImageHeader header;
+    memcpy( header.magic, s_diskMagic, sizeof( s_diskMagic ) );
+    header.version = s_diskVersion;
+    header.width = image.width();
+    header.height = image.height();
+    header.bytesPerLine = image.bytesPerLine();
+    header.format = image.format();
+    header.dataSize = quint64( image.bytesPerLine() ) * quint64( image.height() );
+
+    QSaveFile f( fileName );
+    if ( !f.open( QIODevice::WriteOnly )
+         || f.write( reinterpret_cast< const char* >( &header ), sizeof( header ) ) != qint64( sizeof( header ) )
+         || f.write( reinterpret_cast< const char* >( image.constBits() ), qint64( header.dataSize ) )
+             != qint64( header.dataSize )
+         || !f.commit() )
+    {
+        cWarning() << "Could not cache image in" << fileName;
+    }
+}
+}  // namespace
+
+/// Default memory budget, in KiB
+static constexpr int s_defaultCacheLimit = 32 * 1024;
+
+static QMutex s_cacheMutex;
+static QCache< ImageKey, QImage > s_cache( s_defaultCacheLimit );
+static bool s_diskCacheEnabled = true;
+/// Converted images, so that a hit in pixmap() is cheap; only used from the GUI thread
+static QCache< ImageKey, QPixmap > s_pixmapCache( s_defaultCacheLimit );
 
 
 ImageRegistry*
@@ -50,10 +257,29 @@ ImageRegistry::icon( const QString& image, CalamaresUtils::ImageMode mode )
 }
 
 
-qint64
-ImageRegistry::cacheKey( const QSize& size, qreal opacity, QColor tint )
+void
+ImageRegistry::setCacheLimit( int kibibytes )
+{
+    Q_ASSERT( QThread::currentThread() == QCoreApplication::instance()->thread() );
+    s_pixmapCache.setMaxCost( kibibytes );
+    QMutexLocker lock( &s_cacheMutex );
+    s_cache.setMaxCost( kibibytes );
+}
+
+
+int
+ImageRegistry::cacheLimit() const
+{
+    QMutexLocker lock( &s_cacheMutex );
+    return s_cache.maxCost();
+}
+
+
+void
+ImageRegistry::setDiskCacheEnabled( bool enabled )
 {
-    return size.width() * 100 + size.height() * 10 + static_cast< qint64 >( opacity * 100.0 ) + tint.value();
+    QMutexLocker lock( &s_cacheMutex );
+    s_diskCacheEnabled = enabled;
 }
 
 
@@ -64,37 +290,68 @@ ImageRegistry::pixmap( const QString& image,
                        qreal opacity,
                        QColor tint )
 {
-    Q_ASSERT( !( size.width() < 0 || size.height() < 0 ) );
-    if ( size.width() < 0 || size.height() < 0 )
+    Q_ASSERT( QThread::currentThread() == QCoreApplication::instance()->thread() );
+
+    const ImageKey key( image, size, mode, opacity, tint );
+    const QPixmap* cached = s_pixmapCache.object( key );
+    if ( cached )
+    {
+        return *cached;
+    }
+
+    QPixmap pixmap = QPixmap::fromImage( this->image( image, size, mode, opacity, tint ) );
+    if ( !pixmap.isNull() )
     {
-        return QPixmap();
+        s_pixmapCache.insert( key, new QPixmap( pixmap ), pixmapCost( pixmap ) );
     }
+    return pixmap;
+}
 
-    QHash< qint64, QPixmap > subsubcache;
-    QHash< int, QHash< qint64, QPixmap > > subcache;
 
-    if ( s_cache.contains( image ) )
+QImage
+ImageRegistry::image( const QString& image,
+                      const QSize& size,
+                      CalamaresUtils::ImageMode mode,
+                      qreal opacity,
+                      QColor tint )
+{
+    Q_ASSERT( !( size.width() < 0 || size.height() < 0 ) );
+    if ( size.width() < 0 || size.height() < 0 )
     {
-        subcache = s_cache.value( image );
+        return QImage();
+    }
 
-        if ( subcache.contains( mode ) )
+    const ImageKey key( image, size, mode, opacity, tint );
+    bool useDiskCache = false;
+    {
+        QMutexLocker lock( &s_cacheMutex );
+        const QImage* cached = s_cache.object( key );
+        if ( cached )
         {
-            subsubcache = subcache.value( mode );
-
-            const qint64 ck = cacheKey( size, opacity, tint );
-            if ( subsubcache.contains( ck ) )
-            {
-                return subsubcache.value( ck );
-            }
+            return *cached;
         }
+        useDiskCache = s_diskCacheEnabled;
+    }
+
+    // Image not found in cache. Let's load it; the cache is not locked
+    // while rendering, so two threads may render the same image.
+    const bool isSvg = image.toLower().endsWith( ".svg" );
+    const QString diskName = useDiskCache && ( isSvg || !size.isNull() || mode != CalamaresUtils::Original )
+        ? diskCacheName( key )
+        : QString();
+    QImage rendered = diskName.isEmpty() ? QImage() : loadFromDisk( diskName );
+    if ( !rendered.isNull() )
+    {
+        QMutexLocker lock( &s_cacheMutex );
+        s_cache.insert( key, new QImage( rendered ), imageCost( rendered ) );
+        return rendered;
     }
 
-    // Image not found in cache. Let's load it.
-    QPixmap pixmap;
-    if ( image.toLower().endsWith( ".svg" ) )
+    if ( isSvg )
     {
         QSvgRenderer svgRenderer( image );
-        QPixmap p( size.isNull() || size.height() == 0 || size.width() == 0 ? svgRenderer.defaultSize() : size );
+        QImage p( size.isNull() || size.height() == 0 || size.width() == 0 ? svgRenderer.defaultSize() : size,
+                  QImage::Format_ARGB32_Premultiplied );
         p.fill( Qt::transparent );
 
         QPainter pixPainter( &p );
@@ -106,73 +363,53 @@ ImageRegistry::pixmap( const QString& image,
         {
             QImage resultImage( p.size(), QImage::Format_ARGB32_Premultiplied );
             QPainter painter( &resultImage );
-            painter.drawPixmap( 0, 0, p );
+            painter.drawImage( 0, 0, p );
             painter.setCompositionMode( QPainter::CompositionMode_Screen );
             painter.fillRect( resultImage.rect(), tint );
             painter.end();
 
-            resultImage.setAlphaChannel( p.toImage().alphaChannel() );
-            p = QPixmap::fromImage( resultImage );
+            resultImage.setAlphaChannel( p.alphaChannel() );
+            p = resultImage;
         }
 
-        pixmap = p;
+        rendered = p;
     }
     else
     {
-        pixmap = QPixmap( image );
+        rendered = QImage( image );
     }
 
-    if ( !pixmap.isNull() )
+    if ( !rendered.isNull() )
     {
         if ( mode == CalamaresUtils::RoundedCorners )
         {
-            pixmap = CalamaresUtils::createRoundedImage( pixmap, size );
+            rendered = CalamaresUtils::createRoundedImage( rendered, size );
         }
 
-        if ( !size.isNull() && pixmap.size() != size )
+        if ( !size.isNull() && rendered.size() != size )
         {
             if ( size.width() == 0 )
             {
-                pixmap = pixmap.scaledToHeight( size.height(), Qt::SmoothTransformation );
+                rendered = rendered.scaledToHeight( size.height(), Qt::SmoothTransformation );
             }
             else if ( size.height() == 0 )
             {
-                pixmap = pixmap.scaledToWidth( size.width(), Qt::SmoothTransformation );
+                rendered = rendered.scaledToWidth( size.width(), Qt::SmoothTransformation );
             }
             else
             {
-                pixmap = pixmap.scaled( size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+                rendered = rendered.scaled( size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
             }
         }
 
-        putInCache( image, size, mode, opacity, pixmap, tint );
-    }
-
-    return pixmap;
-}
-
-
-void
-ImageRegistry::putInCache( const QString& image,
-                           const QSize& size,
-                           CalamaresUtils::ImageMode mode,
-                           qreal opacity,
-                           const QPixmap& pixmap,
-                           QColor tint )
-{
-    QHash< qint64, QPixmap > subsubcache;
-    QHash< int, QHash< qint64, QPixmap > > subcache;
-
-    if ( s_cache.contains( image ) )
-    {
-        subcache = s_cache.value( image );
-        if ( subcache.contains( mode ) )
+        if ( !diskName.isEmpty() )
         {
-            subsubcache = subcache.value( mode );
+            saveToDisk( diskName, rendered );
         }
+
+        QMutexLocker lock( &s_cacheMutex );
+        s_cache.insert( key, new QImage( rendered ), imageCost( rendered ) );
     }
 
-    subsubcache.insert( cacheKey( size, opacity, tint ), pixmap );
-    subcache.insert( mode, subsubcache );
-    s_cache.insert( image, subcache );
+    return rendered;
 }
@@ -31,6 +31,23 @@
 #include "DllMacro.h"
 #include "utils/CalamaresUtilsGui.h"
 
+/** @brief Cache of rendered (SVG) icons and scaled images
+ *
+ * Images are cached by filename, size, mode, opacity and tint; the
+ * least-recently-used images are dropped once the cache exceeds
+ * its memory budget (see setCacheLimit()).
+ *
+ * The cache itself is thread-safe, and image() may be called from
+ * any thread, so that images can be prepared in the background.
+ * Use pixmap() and icon() only from the GUI thread; those keep
+ * the pixmaps they hand out in a cache of their own, so that
+ * a hit does not convert the image again.
+ *
+ * Rendered SVGs and transformed images are also kept on disk, in
+ * the application cache directory, keyed by the path, modification time
+ * and size of the file and the rendering parameters. On a later start, these are mapped
+ * into memory instead of being rendered again.
+ */
 class UIDLLEXPORT ImageRegistry
 {
 public:
@@ -44,15 +61,28 @@ public:
                     CalamaresUtils::ImageMode mode = CalamaresUtils::Original,
                     qreal opacity = 1.0,
                     QColor tint = QColor( 0, 0, 0, 0 ) );
+    /// @brief As pixmap(), but returns an image and is safe to call from any thread
+    QImage image( const QString& image,
+                  const QSize& size,
+                  CalamaresUtils::ImageMode mode = CalamaresUtils::Original,
+                  qreal opacity = 1.0,
+                  QColor tint = QColor( 0, 0, 0, 0 ) );
+
+    /** @brief Sets the memory budget of the caches, in KiB
+     *
+     * The budget applies to the image and the pixmap cache each.
+     * Call this from the GUI thread. The branding can set it,
+     * see *imageCache* in branding.desc.
+     */
+    void setCacheLimit( int kibibytes );
+    /// @brief The memory budget of the caches, in KiB
+    int cacheLimit() const;
 
-private:
-    qint64 cacheKey( const QSize& size, qreal opacity, QColor tint );
-    void putInCache( const QString& image,
-                     const QSize& size,
-                     CalamaresUtils::ImageMode mode,
-                     qreal opacity,
-                     const QPixmap& pixmap,
-                     QColor tint );
+    /** @brief Enables or disables the on-disk cache (enabled by default)
+     *
+     * The branding can disable it, see *imageCache* in branding.desc.
+     */
+    void setDiskCacheEnabled( bool enabled );
 };
 
 #endif  // IMAGE_REGISTRY_H
@@ -0,0 +1,127 @@
+/* === This file is part of Calamares - <https://github.com/calamares> ===
+ *
+ *   Copyright 2020, agent <agent@local>
+ *
+ *   Calamares is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Calamares is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Calamares. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Tests.h"
+
+#include "ImageRegistry.h"
+
+#include "utils/Logger.h"
+
+#include <QFile>
+#include <QImage>
+#include <QPixmap>
+
+#include <QtTest/QtTest>
+
+QTEST_MAIN( LibCalamaresUITests )
+
+LibCalamaresUITests::LibCalamaresUITests() {}
+
+LibCalamaresUITests::~LibCalamaresUITests() {}
+
+void
+LibCalamaresUITests::initTestCase()
+{
+    Logger::setupLogLevel( Logger::LOGDEBUG );
+
+    QVERIFY( m_dir.isValid() );
+    m_svg = m_dir.filePath( QStringLiteral( "square.svg" ) );
+    QFile f( m_svg );
+    QVERIFY( f.open( QIODevice::WriteOnly ) );
+    f.write( "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"16\" height=\"16\">"
+             "<rect x=\"2\" y=\"2\" width=\"12\" height=\"12\" fill=\"#336699\"/></svg>\n" );
+    f.close();
+
+    // Only the in-memory caches are tested here
+    ImageRegistry::instance()->setDiskCacheEnabled( false );
+}
+
+void
+LibCalamaresUITests::testCacheLimit()
+{
+    auto* registry = ImageRegistry::instance();
+    const int original = registry->cacheLimit();
+    QVERIFY( original > 0 );
+
+    registry->setCacheLimit( 40 );
+    QCOMPARE( registry->cacheLimit(), 40 );
+
+    // A 128x128 ARGB image costs 64KiB, which is over the limit, so it is not kept
+    QImage big = registry->image( m_svg, QSize( 128, 128 ) );
+    QVERIFY( !big.isNull() );
+    QCOMPARE( big.size(), QSize( 128, 128 ) );
+    QVERIFY( registry->image( m_svg, QSize( 128, 128 ) ).cacheKey() != big.cacheKey() );
+
+    registry->setCacheLimit( original );
+    QCOMPARE( registry->cacheLimit(), original );
+    QCOMPARE( registry->image( m_svg, QSize( 128, 128 ) ).size(), QSize( 128, 128 ) );
+}
+
+void
+LibCalamaresUITests::testImageEviction()
+{
+    auto* registry = ImageRegistry::instance();
+    const int original = registry->cacheLimit();
+    // Each image below costs 15 or 16KiB, so only two of them fit
+    registry->setCacheLimit( 40 );
+
+    const QImage a = registry->image( m_svg, QSize( 64, 64 ) );
+    QVERIFY( !a.isNull() );
+    QCOMPARE( registry->image( m_svg, QSize( 64, 64 ) ).cacheKey(), a.cacheKey() );
+
+    // Other parameters are other images
+    const QImage b = registry->image( m_svg, QSize( 64, 63 ) );
+    QVERIFY( b.cacheKey() != a.cacheKey() );
+    QCOMPARE( registry->image( m_svg, QSize( 64, 64 ) ).cacheKey(), a.cacheKey() );
+
+    // The least-recently-used image, b, is dropped
+    const QImage c = registry->image( m_svg, QSize( 64, 62 ) );
+    QCOMPARE( registry->image( m_svg, QSize( 64, 62 ) ).cacheKey(), c.cacheKey() );
+    QCOMPARE( registry->image( m_svg, QSize( 64, 64 ) ).cacheKey(), a.cacheKey() );
+    const QImage b2 = registry->image( m_svg, QSize( 64, 63 ) );
+    QVERIFY( b2.cacheKey() != b.cacheKey() );
+    QCOMPARE( b2, b );
+
+    // Shrinking the budget drops images right away
+    registry->setCacheLimit( 1 );
+    QVERIFY( registry->image( m_svg, QSize( 64, 63 ) ).cacheKey() != b2.cacheKey() );
+
+    registry->setCacheLimit( original );
+}
+
+void
+LibCalamaresUITests::testPixmapCache()
+{
+    auto* registry = ImageRegistry::instance();
+    const int original = registry->cacheLimit();
+    registry->setCacheLimit( 40 );
+
+    const QPixmap p = registry->pixmap( m_svg, QSize( 32, 32 ) );
+    QVERIFY( !p.isNull() );
+    QCOMPARE( p.size(), QSize( 32, 32 ) );
+    // A hit hands out the same pixmap, without converting again
+    QCOMPARE( registry->pixmap( m_svg, QSize( 32, 32 ) ).cacheKey(), p.cacheKey() );
+    QVERIFY( registry->pixmap( m_svg, QSize( 32, 32 ), CalamaresUtils::Original, 0.5 ).cacheKey() != p.cacheKey() );
+
+    // The pixmap cache has the same budget
+    const QPixmap big = registry->pixmap( m_svg, QSize( 128, 128 ) );
+    QVERIFY( !big.isNull() );
+    QVERIFY( registry->pixmap( m_svg, QSize( 128, 128 ) ).cacheKey() != big.cacheKey() );
+
+    registry->setCacheLimit( original );
+}
@@ -78,6 +78,10 @@ ExecutionViewStep::ExecutionViewStep( QObject* parent )
         cDebug() << "QML load on startup, API 2.";
         loadQmlV2();
     }
+    else
+    {
+        preloadQmlV1();
+    }
 
     connect( JobQueue::instance(), &JobQueue::progress, this, &ExecutionViewStep::updateFromJobQueue );
 #if QT_VERSION >= QT_VERSION_CHECK( 5, 10, 0 )
@@ -151,6 +155,22 @@ ExecutionViewStep::loadQmlV2()
     }
 }
 
+void
+ExecutionViewStep::preloadQmlV1()
+{
+    // The component is never instantiated: API 1 slideshows are loaded
+    // with setSource() on activation. Compiling it now, in the background,
+    // fills the engine's type cache so that setSource() does not have
+    // to compile the QML while the installation is starting.
+    if ( !m_qmlComponent && !Calamares::Branding::instance()->slideshowPath().isEmpty() )
+    {
+        cDebug() << "QML preload on startup, API 1.";
+        m_qmlComponent = new QQmlComponent( m_qmlShow->engine(),
+                                            QUrl::fromLocalFile( Calamares::Branding::instance()->slideshowPath() ),
+                                            QQmlComponent::CompilationMode::Asynchronous );
+    }
+}
+
 /// @brief State-change of the slideshow, for changeSlideShowState()
 enum class Slideshow
 {
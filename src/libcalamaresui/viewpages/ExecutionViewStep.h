@@ -74,6 +74,7 @@ private:
     QStringList m_jobInstanceKeys;
 
     void loadQmlV2();  ///< Loads the slideshow QML (from branding) for API version 2
+    void preloadQmlV1();  ///< Compiles the slideshow QML (from branding) for API version 1
     void updateFromJobQueue( qreal percent, const QString& message );
 };
 
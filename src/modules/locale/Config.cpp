@@ -27,6 +27,7 @@
 #include "JobQueue.h"
 #include "Settings.h"
 
+#include "locale/AvailableLocales.h"
 #include "locale/Label.h"
 #include "locale/TimeZone.h"
 #include "utils/CalamaresUtilsGui.h"
@@ -34,7 +35,6 @@
 #include "utils/Retranslator.h"
 
 #include <QDebug>
-#include <QFile>
 #include <QProcess>
 
 Config::Config( QObject* parent )
@@ -93,103 +93,11 @@ Config::setLocaleInfo( const QString& initialRegion, const QString& initialZone,
         this->m_zonesModel->setCurrentIndex( m_zonesModel->indexOf( "New_York" ) );
     }
 
-    // Some distros come with a meaningfully commented and easy to parse locale.gen,
-    // and others ship a separate file /usr/share/i18n/SUPPORTED with a clean list of
-    // supported locales. We first try that one, and if it doesn't exist, we fall back
-    // to parsing the lines from locale.gen
-    m_localeGenLines.clear();
-    QFile supported( "/usr/share/i18n/SUPPORTED" );
-    QByteArray ba;
-
-    if ( supported.exists() && supported.open( QIODevice::ReadOnly | QIODevice::Text ) )
-    {
-        ba = supported.readAll();
-        supported.close();
-
-        const auto lines = ba.split( '\n' );
-        for ( const QByteArray& line : lines )
-        {
-            m_localeGenLines.append( QString::fromLatin1( line.simplified() ) );
-        }
-    }
-    else
-    {
-        QFile localeGen( localeGenPath );
-        if ( localeGen.open( QIODevice::ReadOnly | QIODevice::Text ) )
-        {
-            ba = localeGen.readAll();
-            localeGen.close();
-        }
-        else
-        {
-            cWarning() << "Cannot open file" << localeGenPath
-                       << ". Assuming the supported languages are already built into "
-                          "the locale archive.";
-            QProcess localeA;
-            localeA.start( "locale", QStringList() << "-a" );
-            localeA.waitForFinished();
-            ba = localeA.readAllStandardOutput();
-        }
-        const auto lines = ba.split( '\n' );
-        for ( const QByteArray& line : lines )
-        {
-            if ( line.startsWith( "## " ) || line.startsWith( "# " ) || line.simplified() == "#" )
-            {
-                continue;
-            }
-
-            QString lineString = QString::fromLatin1( line.simplified() );
-            if ( lineString.startsWith( "#" ) )
-            {
-                lineString.remove( '#' );
-            }
-            lineString = lineString.simplified();
-
-            if ( lineString.isEmpty() )
-            {
-                continue;
-            }
-
-            m_localeGenLines.append( lineString );
-        }
-    }
-
+    m_localeGenLines = CalamaresUtils::Locale::AvailableLocales::get( localeGenPath );
     if ( m_localeGenLines.isEmpty() )
     {
-        cWarning() << "cannot acquire a list of available locales."
-                   << "The locale and localecfg modules will be broken as long as this "
-                      "system does not provide"
-                   << "\n\t  "
-                   << "* a well-formed" << supported.fileName() << "\n\tOR"
-                   << "* a well-formed"
-                   << ( localeGenPath.isEmpty() ? QLatin1String( "/etc/locale.gen" ) : localeGenPath ) << "\n\tOR"
-                   << "* a complete pre-compiled locale-gen database which allows complete locale -a output.";
         return;  // something went wrong and there's nothing we can do about it.
     }
-
-    // Assuming we have a list of supported locales, we usually only want UTF-8 ones
-    // because it's not 1995.
-    for ( auto it = m_localeGenLines.begin(); it != m_localeGenLines.end(); )
-    {
-        if ( !it->contains( "UTF-8", Qt::CaseInsensitive ) && !it->contains( "utf8", Qt::CaseInsensitive ) )
-        {
-            it = m_localeGenLines.erase( it );
-        }
-        else
-        {
-            ++it;
-        }
-    }
-
-    // We strip " UTF-8" from "en_US.UTF-8 UTF-8" because it's redundant redundant.
-    for ( auto it = m_localeGenLines.begin(); it != m_localeGenLines.end(); ++it )
-    {
-        if ( it->endsWith( " UTF-8" ) )
-        {
-            it->chop( 6 );
-        }
-        *it = it->simplified();
-    }
     updateGlobalStorage();
     updateLocaleLabels();
 }
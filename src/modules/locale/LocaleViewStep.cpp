@@ -26,7 +26,7 @@
 #include "JobQueue.h"
 
 #include "geoip/Handler.h"
-#include "network/Manager.h"
+#include "locale/AvailableLocales.h"
 #include "utils/CalamaresUtilsGui.h"
 #include "utils/Logger.h"
 #include "utils/Variant.h"
@@ -88,7 +88,7 @@ LocaleViewStep::fetchGeoIpTimezone()
         m_startingTimezone = m_geoip->get();
         if ( !m_startingTimezone.isValid() )
         {
-            cWarning() << "GeoIP lookup at" << m_geoip->url() << "failed.";
+            cWarning() << "GeoIP lookup failed for all" << m_geoip->providers().count() << "providers.";
         }
     }
 }
@@ -206,19 +206,17 @@ LocaleViewStep::setConfigurationMap( const QVariantMap& configurationMap )
     {
         m_localeGenPath = QStringLiteral( "/etc/locale.gen" );
     }
+    // Look for the available locales while the rest of Calamares starts up
+    CalamaresUtils::Locale::AvailableLocales::start( m_localeGenPath );
 
     bool ok = false;
     QVariantMap geoip = CalamaresUtils::getSubMap( configurationMap, "geoip", ok );
     if ( ok )
     {
-        QString url = CalamaresUtils::getString( geoip, "url" );
-        QString style = CalamaresUtils::getString( geoip, "style" );
-        QString selector = CalamaresUtils::getString( geoip, "selector" );
-
-        m_geoip = std::make_unique< CalamaresUtils::GeoIP::Handler >( style, url, selector );
+        m_geoip = std::make_unique< CalamaresUtils::GeoIP::Handler >( geoip );
         if ( !m_geoip->isValid() )
         {
-            cWarning() << "GeoIP Style" << style << "is not recognized.";
+            cWarning() << "GeoIP configuration has no usable provider.";
         }
     }
 }
@@ -228,18 +226,8 @@ LocaleViewStep::checkRequirements()
 {
     if ( m_geoip && m_geoip->isValid() )
     {
-        auto& network = CalamaresUtils::Network::Manager::instance();
-        if ( network.hasInternet() )
-        {
-            fetchGeoIpTimezone();
-        }
-        else
-        {
-            if ( network.synchronousPing( m_geoip->url() ) )
-            {
-                fetchGeoIpTimezone();
-            }
-        }
+        // See GeoIP::Handler about why there is no ping first
+        fetchGeoIpTimezone();
     }
 
     return Calamares::RequirementsList();
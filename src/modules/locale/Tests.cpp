@@ -25,6 +25,7 @@
 
 #include <QtTest/QtTest>
 
+#include <limits>
 #include <set>
 
 QTEST_MAIN( LocaleTests )
@@ -153,6 +154,35 @@ LocaleTests::testTZImages()
     QCOMPARE( overlapcount, 0 );
 }
 
+void
+LocaleTests::testTZIndex()
+{
+    const auto images = TimeZoneImageList::fromDirectory( SOURCE_DIR );
+    const auto index = TimeZoneIndex::fromDirectory( SOURCE_DIR );
+    QVERIFY( index.isValid() );
+
+    // If this fails, re-run images/zone-index.py
+    const QSize size = TimeZoneImageList::imageSize;
+    int mismatches = 0;
+    for ( int y = 0; y < size.height(); ++y )
+    {
+        for ( int x = 0; x < size.width(); ++x )
+        {
+            const QPoint p( x, y );
+            if ( images.index( p ) != index.index( p ) )
+            {
+                mismatches++;
+            }
+        }
+    }
+    QCOMPARE( mismatches, 0 );
+
+    // Zone images are loaded on demand
+    const QPoint amsterdam = TimeZoneImageList::getLocationPosition( 4.9, 52.37 );
+    QVERIFY( index.index( amsterdam ) >= 0 );
+    QCOMPARE( index.find( amsterdam ), images.find( amsterdam ) );
+}
+
 bool
 operator<( const QPoint& l, const QPoint& r )
 {
@@ -268,3 +298,38 @@ LocaleTests::testSpecificLocations()
     QEXPECT_FAIL( "", "Gibraltar and Ceuta are really close", Continue );
     QVERIFY( gpos.y() < cpos.y() );  // Gibraltar is north of Ceuta
 }
+
+void
+LocaleTests::testLocator()
+{
+    using namespace CalamaresUtils::Locale;
+    const CStringPairList& regions = TZRegion::fromZoneTab();
+    TimeZoneLocator locator( regions );
+
+    auto distance = []( const TZZone* zone, const QPoint& p ) {
+        return ( TimeZoneImageList::getLocationPosition( zone->longitude(), zone->latitude() ) - p ).manhattanLength();
+    };
+
+    // Compare with a brute-force search all over the map
+    const QSize size = TimeZoneImageList::imageSize;
+    for ( int y = 0; y < size.height(); y += 7 )
+    {
+        for ( int x = 0; x < size.width(); x += 13 )
+        {
+            const QPoint p( x, y );
+            int best = std::numeric_limits< int >::max();
+            for ( const auto* pr : regions )
+            {
+                for ( const auto* pz : dynamic_cast< const TZRegion* >( pr )->zones() )
+                {
+                    best = qMin( best, distance( dynamic_cast< const TZZone* >( pz ), p ) );
+                }
+            }
+
+            const auto* found = locator.find( p );
+            QVERIFY( found );
+            // There may be ties, so compare distance rather than zone
+            QCOMPARE( distance( found, p ), best );
+        }
+    }
+}
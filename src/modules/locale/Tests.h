@@ -38,8 +38,10 @@ private Q_SLOTS:
 
     // Check the TZ images for consistency
     void testTZImages();  // No overlaps in images
+    void testTZIndex();  // Index image matches the zone images
     void testTZLocations();  // No overlaps in locations
     void testSpecificLocations();
+    void testLocator();  // Nearest-zone lookup
 };
 
 #endif
@@ -0,0 +1,142 @@
+#! /usr/bin/env python3
+#
+#  === This file is part of Calamares - <https://github.com/calamares> ===
+#
+# Python3 script to build the timezone index image from the zone images.
+#
+### BEGIN LICENSES
+#
+# Copyright 2020 agent <agent@local>
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#
+#   1. Redistributions of source code must retain the above copyright
+#      notice, this list of conditions and the following disclaimer.
+#   2. Redistributions in binary form must reproduce the above copyright
+#      notice, this list of conditions and the following disclaimer in the
+#      documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+### END LICENSES
+
+### BEGIN USAGE
+#
+"""
+Python3 script to build timezone_index.png from the timezone_*.png images.
+
+Run it in the images/ directory of the locale module whenever one of
+the zone images changes. The result is an 8-bit grayscale image the same
+size as the zone images: each pixel holds 1 + the index of the first
+zone image (in the order of zoneNames in TimeZoneImage.cpp) that has
+a non-transparent pixel there, or 0 if no zone image claims the pixel.
+
+Only plain (non-interlaced, 8-bit RGBA or palette) PNG files are
+supported, which is what the zone images are; no imaging library is needed.
+"""
+
+import struct
+import zlib
+
+# Must match zoneNames in TimeZoneImage.cpp
+zone_names = [
+    "0.0", "1.0", "2.0", "3.0", "3.5", "4.0", "4.5", "5.0", "5.5", "5.75", "6.0", "6.5", "7.0",
+    "8.0", "9.0", "9.5", "10.0", "10.5", "11.0", "11.5", "12.0", "12.75", "13.0", "-1.0", "-2.0", "-3.0",
+    "-3.5", "-4.0", "-4.5", "-5.0", "-5.5", "-6.0", "-7.0", "-8.0", "-9.0", "-9.5", "-10.0", "-11.0" ]
+
+PNG_SIGNATURE = b"\x89PNG\r\n\x1a\n"
+
+def read_png(filename):
+    """Returns width, height and a list of rows of RGBA bytes."""
+    with open(filename, "rb") as f:
+        data = f.read()
+    assert data[:8] == PNG_SIGNATURE, filename
+
+    pos = 8
+    idat = b""
+    palette = None
+    transparency = b""
+    while pos < len(data):
+        length, = struct.unpack(">I", data[pos:pos+4])
+        kind = data[pos+4:pos+8]
+        chunk = data[pos+8:pos+8+length]
+        pos += 12 + length
+        if kind == b"IHDR":
+            width, height, depth, color, _, _, interlace = struct.unpack(">IIBBBBB", chunk)
+            assert depth == 8 and color in (3, 6) and interlace == 0, filename
+        elif kind == b"PLTE":
+            palette = chunk
+        elif kind == b"tRNS":
+            transparency = chunk
+        elif kind == b"IDAT":
+            idat += chunk
+
+    raw = zlib.decompress(idat)
+    bpp = 4 if color == 6 else 1
+    stride = width * bpp
+    rows = []
+    previous = bytearray(stride)
+    pos = 0
+    for y in range(height):
+        kind = raw[pos]
+        line = bytearray(raw[pos+1:pos+1+stride])
+        pos += 1 + stride
+        for i in range(stride):
+            a = line[i-bpp] if i >= bpp else 0
+            b = previous[i]
+            c = previous[i-bpp] if i >= bpp else 0
+            if kind == 1:
+                line[i] = (line[i] + a) & 0xff
+            elif kind == 2:
+                line[i] = (line[i] + b) & 0xff
+            elif kind == 3:
+                line[i] = (line[i] + ((a + b) >> 1)) & 0xff
+            elif kind == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                predictor = a if (pa <= pb and pa <= pc) else (b if pb <= pc else c)
+                line[i] = (line[i] + predictor) & 0xff
+        previous = line
+        if color == 3:
+            # Palette entries without a transparency value are opaque
+            line = b"".join(palette[3*i:3*i+3] + (transparency[i:i+1] or b"\xff") for i in line)
+        rows.append(bytes(line))
+    return width, height, rows
+
+def write_gray_png(filename, width, height, rows):
+    def chunk(kind, data):
+        return struct.pack(">I", len(data)) + kind + data + struct.pack(">I", zlib.crc32(kind + data) & 0xffffffff)
+
+    raw = b"".join(b"\x00" + bytes(row) for row in rows)
+    with open(filename, "wb") as f:
+        f.write(PNG_SIGNATURE)
+        f.write(chunk(b"IHDR", struct.pack(">IIBBBBB", width, height, 8, 0, 0, 0, 0)))
+        f.write(chunk(b"IDAT", zlib.compress(raw, 9)))
+        f.write(chunk(b"IEND", b""))
+
+if __name__ == "__main__":
+    index = None
+    for n, name in enumerate(zone_names):
+        width, height, rows = read_png("timezone_{!s}.png".format(name))
+        if index is None:
+            index = [bytearray(width) for _ in range(height)]
+        for y in range(height):
+            row = rows[y]
+            target = index[y]
+            for x in range(width):
+                # Same test as TimeZoneImageList::index(): any bits set
+                if not target[x] and row[4*x:4*x+4] != b"\x00\x00\x00\x00":
+                    target[x] = n + 1
+    write_gray_png("timezone_index.png", width, height, index)
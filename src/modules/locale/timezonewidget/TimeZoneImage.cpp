@@ -22,7 +22,9 @@
 
 #include <QDir>
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 static const char* zoneNames[]
     = { "0.0",  "1.0",  "2.0",  "3.0",  "3.5",  "4.0",  "4.5",  "5.0",  "5.5",   "5.75", "6.0",   "6.5",  "7.0",
@@ -210,3 +212,164 @@ TimeZoneImageList::find( QPoint p ) const
     }
     return at( i );
 }
+
+static const char TZ_INDEX_NAME[] = "timezone_index.png";
+
+TimeZoneIndex::TimeZoneIndex( const QImage& index, const QString& prefix )
+    : m_index( index.convertToFormat( QImage::Format_Grayscale8 ) )
+    , m_prefix( prefix )
+{
+    if ( !m_index.isNull() && m_index.size() != TimeZoneImageList::imageSize )
+    {
+        cWarning() << "TimeZone index has size" << m_index.size() << "expected" << TimeZoneImageList::imageSize;
+        m_index = QImage();
+    }
+}
+
+TimeZoneIndex
+TimeZoneIndex::fromQRC()
+{
+    return TimeZoneIndex( QImage( QStringLiteral( ":/images/" ) + TZ_INDEX_NAME ),
+                          QStringLiteral( ":/images/timezone_" ) );
+}
+
+TimeZoneIndex
+TimeZoneIndex::fromDirectory( const QString& dirName )
+{
+    QDir dir( dirName );
+    QImage index( dir.filePath( TZ_INDEX_NAME ) );
+    if ( index.isNull() )
+    {
+        index = fromImages( TimeZoneImageList::fromDirectory( dirName ) );
+    }
+    return TimeZoneIndex( index, dir.filePath( QStringLiteral( "timezone_" ) ) );
+}
+
+QImage
+TimeZoneIndex::fromImages( const TimeZoneImageList& images )
+{
+    if ( images.count() != TimeZoneImageList::zoneCount
+         || std::any_of( images.cbegin(), images.cend(), []( const QImage& i ) {
+                return i.size() != TimeZoneImageList::imageSize;
+            } ) )
+    {
+        cWarning() << "TimeZone images are incomplete, no index.";
+        return QImage();
+    }
+
+    QImage index( TimeZoneImageList::imageSize, QImage::Format_Grayscale8 );
+    index.fill( 0 );
+    for ( int y = 0; y < index.height(); ++y )
+    {
+        uchar* line = index.scanLine( y );
+        for ( int x = 0; x < index.width(); ++x )
+        {
+            line[ x ] = uchar( images.index( QPoint( x, y ) ) + 1 );
+        }
+    }
+    return index;
+}
+
+int
+TimeZoneIndex::index( QPoint p ) const
+{
+    if ( !m_index.valid( p ) )
+    {
+        return -1;
+    }
+    const int i = m_index.constScanLine( p.y() )[ p.x() ];
+    return i > 0 && i <= TimeZoneImageList::zoneCount ? i - 1 : -1;
+}
+
+QImage
+TimeZoneIndex::find( QPoint p ) const
+{
+    const int i = index( p );
+    if ( i < 0 )
+    {
+        return QImage();
+    }
+    if ( i != m_loadedIndex )
+    {
+        m_loadedImage = QImage( m_prefix + zoneNames[ i ] + QStringLiteral( ".png" ) );
+        m_loadedIndex = i;
+    }
+    return m_loadedImage;
+}
+
+
+/* static constexpr */ const int TimeZoneLocator::cellSize;
+
+TimeZoneLocator::TimeZoneLocator( const CalamaresUtils::Locale::CStringPairList& regions )
+    : m_columns( ( TimeZoneImageList::imageSize.width() + cellSize - 1 ) / cellSize )
+    , m_rows( ( TimeZoneImageList::imageSize.height() + cellSize - 1 ) / cellSize )
+    , m_cells( m_columns * m_rows )
+{
+    using namespace CalamaresUtils::Locale;
+    for ( const auto* region_p : regions )
+    {
+        const auto* region = dynamic_cast< const TZRegion* >( region_p );
+        if ( !region )
+        {
+            continue;
+        }
+        for ( const auto* zone_p : region->zones() )
+        {
+            const auto* zone = dynamic_cast< const TZZone* >( zone_p );
+            if ( zone )
+            {
+                // getLocationPosition() wraps around, so this is always on the map
+                const QPoint pos = TimeZoneImageList::getLocationPosition( zone->longitude(), zone->latitude() );
+                m_cells[ cellIndex( pos.x() / cellSize, pos.y() / cellSize ) ].append( Entry { pos, zone } );
+            }
+        }
+    }
+}
+
+const TimeZoneLocator::TZZone*
+TimeZoneLocator::find( QPoint p ) const
+{
+    const int column = qBound( 0, p.x() / cellSize, m_columns - 1 );
+    const int row = qBound( 0, p.y() / cellSize, m_rows - 1 );
+
+    const TZZone* closest = nullptr;
+    int closestDistance = std::numeric_limits< int >::max();
+
+    // Look at rings of buckets around the one containing p. Any zone
+    // in ring r (or further out) is more than (r-1) * cellSize away,
+    // so once something at least that close is found, the search is done.
+    const int maxRing = qMax( m_columns, m_rows );
+    for ( int ring = 0; ring <= maxRing; ++ring )
+    {
+        if ( closest && closestDistance <= ( ring - 1 ) * cellSize )
+        {
+            break;
+        }
+        for ( int r = row - ring; r <= row + ring; ++r )
+        {
+            if ( r < 0 || r >= m_rows )
+            {
+                continue;
+            }
+            // Only the edge of the ring: all of the top and bottom rows, the ends of the others
+            const int step = ( r == row - ring || r == row + ring ) ? 1 : qMax( 1, 2 * ring );
+            for ( int c = column - ring; c <= column + ring; c += step )
+            {
+                if ( c < 0 || c >= m_columns )
+                {
+                    continue;
+                }
+                for ( const auto& e : m_cells.at( cellIndex( c, r ) ) )
+                {
+                    const int distance = ( e.position - p ).manhattanLength();
+                    if ( distance < closestDistance )
+                    {
+                        closest = e.zone;
+                        closestDistance = distance;
+                    }
+                }
+            }
+        }
+    }
+    return closest;
+}
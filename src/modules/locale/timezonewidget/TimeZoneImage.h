@@ -19,8 +19,11 @@
 #ifndef TIMEZONEIMAGE_H
 #define TIMEZONEIMAGE_H
 
+#include "locale/TimeZone.h"
+
 #include <QImage>
 #include <QList>
+#include <QVector>
 
 using TimeZoneImage = QImage;
 
@@ -82,4 +85,85 @@ public:
     static constexpr const QSize imageSize = QSize( 780, 340 );
 };
 
+/** @brief Index of which zone image claims each spot on the map
+ *
+ * This is an 8-bit image the same size as the zone images; each
+ * pixel is 0 (unclaimed) or 1 + the index of the first zone image
+ * that claims the spot, so finding a zone is a single pixel lookup.
+ * The index is built from the zone images by `images/zone-index.py`.
+ *
+ * Only the image of the zone that is asked for with find() is
+ * loaded (and kept until another zone is asked for); the rest
+ * of the zone images are never decoded.
+ */
+class TimeZoneIndex
+{
+public:
+    /// @brief Loads the index from QRC; zone images come from QRC as well
+    static TimeZoneIndex fromQRC();
+    /** @brief Loads the index from a specified directory
+     *
+     * If there is no index image in the directory, it is
+     * computed from the zone images there (which is slow).
+     */
+    static TimeZoneIndex fromDirectory( const QString& dirName );
+
+    /// @brief As TimeZoneImageList::index()
+    int index( QPoint p ) const;
+    /// @brief As TimeZoneImageList::find()
+    QImage find( QPoint p ) const;
+
+    bool isValid() const { return !m_index.isNull(); }
+
+private:
+    TimeZoneIndex( const QImage& index, const QString& prefix );
+    /// @brief Computes the index from a list of zone images
+    static QImage fromImages( const TimeZoneImageList& images );
+
+    QImage m_index;  ///< Grayscale8
+    QString m_prefix;  ///< Where to load zone images from (path up to "timezone_")
+
+    mutable int m_loadedIndex = -1;
+    mutable QImage m_loadedImage;
+};
+
+/** @brief Finds the zone nearest to a spot on the map
+ *
+ * The map positions of all the zones are computed once, and
+ * bucketed in a coarse grid over the map. Looking up the
+ * nearest zone only examines the buckets near the spot,
+ * so it is cheap enough to do on every mouse-move.
+ */
+class TimeZoneLocator
+{
+public:
+    using TZZone = CalamaresUtils::Locale::TZZone;
+
+    /// @brief Index all the zones in @p regions (e.g. from TZRegion::fromZoneTab())
+    explicit TimeZoneLocator( const CalamaresUtils::Locale::CStringPairList& regions );
+
+    /** @brief The zone nearest to @p p
+     *
+     * Distance is measured in pixels, "taxicab" style. Returns
+     * nullptr only if there are no zones at all.
+     */
+    const TZZone* find( QPoint p ) const;
+
+    /// @brief Size of the (square) buckets, in pixels
+    static constexpr const int cellSize = 20;
+
+private:
+    struct Entry
+    {
+        QPoint position;
+        const TZZone* zone;
+    };
+
+    int cellIndex( int column, int row ) const { return row * m_columns + column; }
+
+    int m_columns;
+    int m_rows;
+    QVector< QVector< Entry > > m_cells;
+};
+
 #endif
@@ -36,9 +36,10 @@
 
 TimeZoneWidget::TimeZoneWidget( QWidget* parent )
     : QWidget( parent )
-    , timeZoneImages( TimeZoneImageList::fromQRC() )
+    , timeZoneImages( TimeZoneIndex::fromQRC() )
+    , m_locator( CalamaresUtils::Locale::TZRegion::fromZoneTab() )
 {
-    setMouseTracking( false );
+    setMouseTracking( true );
     setCursor( Qt::PointingHandCursor );
 
     // Font
@@ -188,35 +189,7 @@ TimeZoneWidget::mousePressEvent( QMouseEvent* event )
         return;
     }
 
-    // Set nearest location
-    int nX = 999999, mX = event->pos().x();
-    int nY = 999999, mY = event->pos().y();
-
-    using namespace CalamaresUtils::Locale;
-    const TZZone* closest = nullptr;
-    for ( const auto* region_p : TZRegion::fromZoneTab() )
-    {
-        const auto* region = dynamic_cast< const TZRegion* >( region_p );
-        if ( region )
-        {
-            for ( const auto* zone_p : region->zones() )
-            {
-                const auto* zone = dynamic_cast< const TZZone* >( zone_p );
-                if ( zone )
-                {
-                    QPoint locPos = TimeZoneImageList::getLocationPosition( zone->longitude(), zone->latitude() );
-
-                    if ( ( abs( mX - locPos.x() ) + abs( mY - locPos.y() ) < abs( mX - nX ) + abs( mY - nY ) ) )
-                    {
-                        closest = zone;
-                        nX = locPos.x();
-                        nY = locPos.y();
-                    }
-                }
-            }
-        }
-    }
-
+    const auto* closest = m_locator.find( event->pos() );
     if ( closest )
     {
         // Set zone image and repaint widget
@@ -225,3 +198,16 @@ TimeZoneWidget::mousePressEvent( QMouseEvent* event )
         emit locationChanged( m_currentLocation );
     }
 }
+
+
+void
+TimeZoneWidget::mouseMoveEvent( QMouseEvent* event )
+{
+    // Name the zone that a click would select
+    const auto* hover = m_locator.find( event->pos() );
+    if ( hover != m_hoverLocation )
+    {
+        m_hoverLocation = hover;
+        setToolTip( hover ? hover->tr() : QString() );
+    }
+}
@@ -50,16 +50,19 @@ signals:
 private:
     QFont font;
     QImage background, pin, currentZoneImage;
-    TimeZoneImageList timeZoneImages;
+    TimeZoneIndex timeZoneImages;
+    TimeZoneLocator m_locator;
     const TZZone* m_currentLocation = nullptr;  // Not owned by me
+    const TZZone* m_hoverLocation = nullptr;  // Not owned by me
 
     QPoint getLocationPosition( const TZZone* l )
     {
-        return timeZoneImages.getLocationPosition( l->longitude(), l->latitude() );
+        return TimeZoneImageList::getLocationPosition( l->longitude(), l->latitude() );
     }
 
     void paintEvent( QPaintEvent* event );
     void mousePressEvent( QMouseEvent* event );
+    void mouseMoveEvent( QMouseEvent* event );
 };
 
 #endif  // TIMEZONEWIDGET_H
@@ -27,6 +27,7 @@
 #include "utils/Yaml.h"
 
 #include <QNetworkReply>
+#include <QTimer>
 
 Config::Config( QObject* parent )
     : QObject( parent )
@@ -81,9 +82,16 @@ Config::loadGroupList( const QUrl& url )
     using namespace CalamaresUtils::Network;
 
     cDebug() << "NetInstall loading groups from" << url;
-    QNetworkReply* reply = Manager::instance().asynchronousGet(
-        url,
-        RequestOptions( RequestOptions::FakeUserAgent | RequestOptions::FollowRedirect, std::chrono::seconds( 30 ) ) );
+    requestGroupList( url,
+                      RequestOptions( RequestOptions::FakeUserAgent | RequestOptions::FollowRedirect
+                                          | RequestOptions::UseCache,
+                                      std::chrono::seconds( 30 ) ) );
+}
+
+void
+Config::requestGroupList( const QUrl& url, const CalamaresUtils::Network::RequestOptions& options )
+{
+    QNetworkReply* reply = CalamaresUtils::Network::Manager::instance().asynchronousGet( url, options );
 
     if ( !reply )
     {
@@ -107,7 +115,8 @@ Config::receivedGroupData()
         return;
     }
 
-    cDebug() << "NetInstall group data received" << m_reply->size() << "bytes from" << m_reply->url();
+    cDebug() << "NetInstall group data received" << m_reply->size() << "bytes from" << m_reply->url()
+             << ( m_reply->attribute( QNetworkRequest::SourceIsFromCacheAttribute ).toBool() ? "(cached)" : "" );
 
     cqDeleter< QNetworkReply > d { m_reply };
 
@@ -119,6 +128,22 @@ Config::receivedGroupData()
         cDebug() << Logger::SubEntry << "Netinstall reply error: " << m_reply->error();
         cDebug() << Logger::SubEntry << "Request for url: " << m_reply->url().toString()
                  << " failed with: " << m_reply->errorString();
+
+        using namespace CalamaresUtils::Network;
+        const auto loadControl = m_reply->request().attribute( QNetworkRequest::CacheLoadControlAttribute );
+        if ( loadControl.toInt() != QNetworkRequest::AlwaysCache )
+        {
+            // Offline fallback: use the last good copy, if there is one.
+            // This is queued so that the failed reply is cleaned up first.
+            cDebug() << Logger::SubEntry << "Trying cached copy of the groups data.";
+            QTimer::singleShot( 0, this, [ this, url = m_reply->request().url() ]() {
+                requestGroupList( url,
+                                  RequestOptions( RequestOptions::FakeUserAgent | RequestOptions::FollowRedirect
+                                                      | RequestOptions::CacheOnly,
+                                                  std::chrono::seconds( 30 ) ) );
+            } );
+            return;
+        }
         setStatus( Status::FailedNetworkError );
         return;
     }
@@ -28,6 +28,14 @@
 
 class QNetworkReply;
 
+namespace CalamaresUtils
+{
+namespace Network
+{
+class RequestOptions;
+}  // namespace Network
+}  // namespace CalamaresUtils
+
 class Config : public QObject
 {
     Q_OBJECT
@@ -78,6 +86,9 @@ private slots:
     void receivedGroupData();  ///< From async-loading group data
 
 private:
+    /// @brief Starts the request for group data; receivedGroupData() is called when done
+    void requestGroupList( const QUrl& url, const CalamaresUtils::Network::RequestOptions& options );
+
     PackageModel* m_model = nullptr;
     QNetworkReply* m_reply = nullptr;  // For fetching data
     Status m_status = Status::Ok;
@@ -26,6 +26,7 @@
 #include "GlobalStorage.h"
 #include "JobQueue.h"
 #include "partition/PartitionIterator.h"
+#include "partition/Probe.h"
 #include "utils/Logger.h"
 
 #include <kpmcore/backend/corebackend.h>
@@ -33,8 +34,12 @@
 #include <kpmcore/core/device.h>
 #include <kpmcore/core/partition.h>
 
-#include <QProcess>
+#include <QPair>
+#include <QSet>
+#include <QStringList>
 #include <QTemporaryDir>
+#include <QVector>
+#include <QtConcurrent/QtConcurrentMap>
 
 using CalamaresUtils::Partition::PartitionIterator;
 
@@ -57,39 +62,29 @@ hasRootPartition( Device* device )
 }
 
 static bool
-blkIdCheckIso9660( const QString& path )
+isIso9660( const QString& path )
 {
-    QProcess blkid;
-    blkid.start( "blkid", { path } );
-    blkid.waitForFinished();
-    QString output = QString::fromLocal8Bit( blkid.readAllStandardOutput() );
-    return output.contains( "iso9660" );
+    return CalamaresUtils::Partition::probeFileSystemType( path ) == QStringLiteral( "iso9660" );
 }
 
-static bool
-isIso9660( const Device* device )
+/// @brief The paths to probe for iso9660 on @p device: the device and its partitions
+static QStringList
+iso9660Paths( const Device* device )
 {
-    const QString path = device->deviceNode();
-    if ( path.isEmpty() )
+    QStringList paths;
+    if ( !device || device->deviceNode().isEmpty() )
     {
-        return false;
+        return paths;
     }
-    if ( blkIdCheckIso9660( path ) )
-    {
-        return true;
-    }
-
-    if ( device->partitionTable() && !device->partitionTable()->children().isEmpty() )
+    paths.append( device->deviceNode() );
+    if ( device->partitionTable() )
     {
         for ( const Partition* partition : device->partitionTable()->children() )
         {
-            if ( blkIdCheckIso9660( partition->partitionPath() ) )
-            {
-                return true;
-            }
+            paths.append( partition->partitionPath() );
         }
     }
-    return false;
+    return paths;
 }
 
 
@@ -131,6 +126,32 @@ getDevices( DeviceType which, qint64 minimumSize )
 #else
     cDebug() << "Removing unsuitable devices:" << devices.count() << "candidates.";
 
+    // Probing for iso9660 reads from the device and each of its partitions,
+    // which can be slow (e.g. for optical drives), so probe all of those
+    // at once, not just one device at a time; the devices are then removed
+    // in their original order.
+    QSet< Device* > iso9660Devices;
+    if ( writableOnly )
+    {
+        QVector< QPair< Device*, QString > > probes;
+        for ( Device* device : devices )
+        {
+            for ( const QString& path : iso9660Paths( device ) )
+            {
+                probes.append( qMakePair( device, path ) );
+            }
+        }
+        const auto isIso = QtConcurrent::blockingMapped< QVector< bool > >(
+            probes, []( const QPair< Device*, QString >& probe ) { return isIso9660( probe.second ); } );
+        for ( int i = 0; i < probes.count(); ++i )
+        {
+            if ( isIso.at( i ) )
+            {
+                iso9660Devices.insert( probes.at( i ).first );
+            }
+        }
+    }
+
     // Remove the device which contains / from the list
     for ( DeviceList::iterator it = devices.begin(); it != devices.end(); )
         if ( !( *it ) )
@@ -148,7 +169,7 @@ getDevices( DeviceType which, qint64 minimumSize )
             cDebug() << Logger::SubEntry << "Removing device with root filesystem (/) on it" << it;
             it = erase( devices, it );
         }
-        else if ( writableOnly && isIso9660( *it ) )
+        else if ( iso9660Devices.contains( *it ) )
         {
             cDebug() << Logger::SubEntry << "Removing device with iso9660 filesystem (probably a CD) on it" << it;
             it = erase( devices, it );
@@ -132,4 +132,44 @@ clonePartition( Device* device, Partition* partition )
                           partition->activeFlags() );
 }
 
+
+/// @brief Are there LUKS partitions under @p node?
+static bool
+hasLuksPartitions( const PartitionNode* node )
+{
+    for ( const Partition* partition : node->children() )
+    {
+        const FileSystem::Type type = partition->fileSystem().type();
+#if defined( WITH_KPMCORE4API )
+        if ( type == FileSystem::Type::Luks || type == FileSystem::Type::Luks2 )
+#else
+        if ( type == FileSystem::Type::Luks )
+#endif
+        {
+            return true;
+        }
+        if ( hasLuksPartitions( partition ) )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool
+restorePartitionTable( Device* device, const PartitionTable* original )
+{
+    if ( original && hasLuksPartitions( original ) )
+    {
+        return false;
+    }
+
+    // Device takes ownership of its table, but does not destroy the current
+    // one when setPartitionTable() is called, so do it ourself
+    delete device->partitionTable();
+    device->setPartitionTable( original ? new PartitionTable( *original ) : nullptr );
+    return true;
+}
+
 }  // namespace KPMHelpers
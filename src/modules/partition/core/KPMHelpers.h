@@ -79,6 +79,15 @@ Partition* createNewEncryptedPartition( PartitionNode* parent,
 
 Partition* clonePartition( Device* device, Partition* partition );
 
+/** @brief Replaces the partition table of @p device by a copy of @p original
+ *
+ * A copied partition gets a new filesystem of the same type, without
+ * the LUKS state (e.g. the inner filesystem) that KPMcore sets up when
+ * scanning. So if @p original has LUKS partitions, nothing is copied
+ * and this returns @c false; rescan the device instead.
+ */
+bool restorePartitionTable( Device* device, const PartitionTable* original );
+
 }  // namespace KPMHelpers
 
 #endif /* KPMHELPERS_H */
@@ -22,16 +22,16 @@
 
 #include "PartitionCoreModule.h"
 
-#include "core/DeviceModel.h"
 #include "core/KPMHelpers.h"
 #include "core/PartitionInfo.h"
 
 #include "GlobalStorage.h"
 #include "JobQueue.h"
+#include "partition/ExtReader.h"
 #include "partition/Mount.h"
 #include "partition/PartitionIterator.h"
 #include "partition/PartitionQuery.h"
-#include "utils/CalamaresUtilsSystem.h"
+#include "partition/Probe.h"
 #include "utils/Logger.h"
 
 #include <kpmcore/backend/corebackend.h>
@@ -39,8 +39,14 @@
 #include <kpmcore/core/device.h>
 #include <kpmcore/core/partition.h>
 
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
 #include <QProcess>
 #include <QTemporaryDir>
+#include <QtConcurrent/QtConcurrentRun>
 
 using CalamaresUtils::Partition::isPartitionFreeSpace;
 using CalamaresUtils::Partition::isPartitionNew;
@@ -213,15 +219,10 @@ canBeResized( PartitionCoreModule* core, const QString& partitionPath )
     QString partitionWithOs = partitionPath;
     if ( partitionWithOs.startsWith( "/dev/" ) )
     {
-        DeviceModel* dm = core->deviceModel();
-        for ( int i = 0; i < dm->rowCount(); ++i )
+        Partition* candidate = core->findPartitionByPath( partitionWithOs );
+        if ( candidate )
         {
-            Device* dev = dm->deviceForIndex( dm->index( i ) );
-            Partition* candidate = CalamaresUtils::Partition::findPartitionByPath( { dev }, partitionWithOs );
-            if ( candidate )
-            {
-                return canBeResized( candidate );
-            }
+            return canBeResized( candidate );
         }
         cDebug() << Logger::SubEntry << "no Partition* found for" << partitionWithOs;
     }
@@ -232,26 +233,69 @@ canBeResized( PartitionCoreModule* core, const QString& partitionPath )
 
 
 static FstabEntryList
-lookForFstabEntries( const QString& partitionPath )
+fstabEntriesFromData( const QByteArray& data )
 {
-    QStringList mountOptions { "ro" };
+    FstabEntryList fstabEntries;
+    const QStringList fstabLines = QString::fromLocal8Bit( data ).split( '\n' );
 
-    auto r = CalamaresUtils::System::runCommand( CalamaresUtils::System::RunLocation::RunInHost,
-                                                 { "blkid", "-s", "TYPE", "-o", "value", partitionPath } );
-    if ( r.getExitCode() )
+    for ( const QString& rawLine : fstabLines )
     {
-        cWarning() << "blkid on" << partitionPath << "failed.";
+        fstabEntries.append( FstabEntry::fromEtcFstab( rawLine ) );
     }
-    else
+    cDebug() << Logger::SubEntry << "got" << fstabEntries.count() << "lines.";
+    std::remove_if( fstabEntries.begin(), fstabEntries.end(), []( const FstabEntry& x ) { return !x.isValid(); } );
+    cDebug() << Logger::SubEntry << "got" << fstabEntries.count() << "fstab entries.";
+    return fstabEntries;
+}
+
+/** @brief Reads the fstab on @p partitionPath, if that can be done without mounting
+ *
+ * Returns @c true if it could, and then @p fstabEntries holds the entries
+ * (none, if there is no fstab). Returns @c false if the partition needs
+ * to be mounted to find out, see lookForMountedFstabEntries().
+ */
+static bool
+lookForUnmountedFstabEntries( const QString& partitionPath, FstabEntryList& fstabEntries )
+{
+    const QString fstype = CalamaresUtils::Partition::probeFileSystemType( partitionPath );
+    cDebug() << "Checking device" << partitionPath << "for fstab (fs=" << fstype << ')';
+
+    // ext2/3/4 can be read without mounting; only if the filesystem
+    // can't be read that way, mount it after all.
+    if ( fstype.startsWith( "ext" ) )
     {
-        QString fstype = r.getOutput().trimmed();
-        if ( ( fstype == "ext3" ) || ( fstype == "ext4" ) )
+        using CalamaresUtils::Partition::ExtReadResult;
+        ExtReadResult result = ExtReadResult::Unreadable;
+        const QByteArray fstab = CalamaresUtils::Partition::readExtFile( partitionPath, "/etc/fstab", &result );
+        if ( result == ExtReadResult::Ok )
+        {
+            cDebug() << Logger::SubEntry << "read /etc/fstab of" << partitionPath << "without mounting.";
+            fstabEntries = fstabEntriesFromData( fstab );
+            return true;
+        }
+        if ( result == ExtReadResult::NotFound )
         {
-            mountOptions.append( "noload" );
+            cDebug() << Logger::SubEntry << "there is no /etc/fstab on" << partitionPath;
+            fstabEntries.clear();
+            return true;
         }
     }
+    return false;
+}
+
+/// @brief Mounts @p partitionPath (read-only) and reads the fstab in it
+static FstabEntryList
+lookForMountedFstabEntries( const QString& partitionPath )
+{
+    QStringList mountOptions { "ro" };
+
+    const QString fstype = CalamaresUtils::Partition::probeFileSystemType( partitionPath );
+    if ( ( fstype == "ext3" ) || ( fstype == "ext4" ) )
+    {
+        mountOptions.append( "noload" );
+    }
 
-    cDebug() << "Checking device" << partitionPath << "for fstab (fs=" << r.getOutput() << ')';
+    cDebug() << "Mounting device" << partitionPath << "for fstab (fs=" << fstype << ')';
 
     FstabEntryList fstabEntries;
 
@@ -264,17 +308,8 @@ lookForFstabEntries( const QString& partitionPath )
 
         if ( fstabFile.open( QIODevice::ReadOnly | QIODevice::Text ) )
         {
-            const QStringList fstabLines = QString::fromLocal8Bit( fstabFile.readAll() ).split( '\n' );
-
-            for ( const QString& rawLine : fstabLines )
-            {
-                fstabEntries.append( FstabEntry::fromEtcFstab( rawLine ) );
-            }
+            fstabEntries = fstabEntriesFromData( fstabFile.readAll() );
             fstabFile.close();
-            cDebug() << Logger::SubEntry << "got" << fstabEntries.count() << "lines.";
-            std::remove_if(
-                fstabEntries.begin(), fstabEntries.end(), []( const FstabEntry& x ) { return !x.isValid(); } );
-            cDebug() << Logger::SubEntry << "got" << fstabEntries.count() << "fstab entries.";
         }
         else
         {
@@ -366,10 +401,75 @@ findPartitionPathForMountPoint( const FstabEntryList& fstab, const QString& moun
 }
 
 
-OsproberEntryList
-runOsprober( PartitionCoreModule* core )
+/// @brief Parses one line of os-prober output; the entry has no path if the line is not useful
+static OsproberEntry
+osproberEntry( const QString& line )
+{
+    OsproberEntry entry { QString(), QString(), QString(), false, QStringList(), FstabEntryList(), QString() };
+    if ( line.simplified().isEmpty() )
+    {
+        return entry;
+    }
+
+    QStringList lineColumns = line.split( ':' );
+    if ( !lineColumns.value( 1 ).simplified().isEmpty() )
+    {
+        entry.prettyName = lineColumns.value( 1 ).simplified();
+    }
+    else if ( !lineColumns.value( 2 ).simplified().isEmpty() )
+    {
+        entry.prettyName = lineColumns.value( 2 ).simplified();
+    }
+
+    QString path = lineColumns.value( 0 ).simplified();
+    if ( path.startsWith( "/dev/" ) )  //basic sanity check
+    {
+        entry.path = path;
+        entry.line = lineColumns;
+    }
+    return entry;
+}
+
+/// @brief An os-prober entry, with its fstab if that could be read without mounting
+struct UnmountedOsproberEntry
+{
+    OsproberEntry entry;
+    bool needsMount = false;  ///< The fstab (and home path) can only be found by mounting
+};
+
+/// @brief Fills in the fstab-related parts of the @p entry, if that can be done without mounting
+static UnmountedOsproberEntry
+withUnmountedFstab( OsproberEntry entry )
+{
+    const bool found = lookForUnmountedFstabEntries( entry.path, entry.fstab );
+    if ( found )
+    {
+        entry.homePath = findPartitionPathForMountPoint( entry.fstab, "/home" );
+    }
+    return UnmountedOsproberEntry { entry, !found };
+}
+
+/// @brief Fills in the fstab-related parts of the @p entry (this mounts the partition)
+static OsproberEntry
+withMountedFstab( OsproberEntry entry )
+{
+    entry.fstab = lookForMountedFstabEntries( entry.path );
+    entry.homePath = findPartitionPathForMountPoint( entry.fstab, "/home" );
+    return entry;
+}
+
+/** @brief Runs os-prober and reads the fstab of each OS it finds
+ *
+ * The output of os-prober is read line-by-line while it runs, and the
+ * fstab for each entry is read (in another thread) as soon as the line
+ * for it arrives, while os-prober goes on looking at other partitions.
+ * That only happens for filesystems that can be read without mounting
+ * them: os-prober mounts partitions itself, and doesn't expect others
+ * to do the same. The remaining ones are mounted once os-prober is done.
+ */
+static OsproberEntryList
+discoverOsprober()
 {
-    QString osproberOutput;
     QProcess osprober;
     osprober.setProgram( "os-prober" );
     osprober.setProcessChannelMode( QProcess::SeparateChannels );
@@ -377,47 +477,89 @@ runOsprober( PartitionCoreModule* core )
     if ( !osprober.waitForStarted() )
     {
         cError() << "os-prober cannot start.";
+        return OsproberEntryList();
+    }
+
+    QList< QFuture< UnmountedOsproberEntry > > entries;
+    auto takeLine = [ &entries ]( const QByteArray& rawLine ) {
+        OsproberEntry entry = osproberEntry( QString::fromLocal8Bit( rawLine ).trimmed() );
+        if ( !entry.path.isEmpty() )
+        {
+            entries.append( QtConcurrent::run( withUnmountedFstab, entry ) );
+        }
+    };
+
+    constexpr qint64 timeout = 60000;  // msec
+    QElapsedTimer timer;
+    timer.start();
+    while ( osprober.state() != QProcess::NotRunning && !timer.hasExpired( timeout ) )
+    {
+        osprober.waitForReadyRead( int( qBound( qint64( 1 ), timeout - timer.elapsed(), timeout ) ) );
+        while ( osprober.canReadLine() )
+        {
+            takeLine( osprober.readLine() );
+        }
     }
-    else if ( !osprober.waitForFinished( 60000 ) )
+    if ( osprober.state() != QProcess::NotRunning )
     {
         cError() << "os-prober timed out.";
+        osprober.kill();
+        osprober.waitForFinished();
     }
     else
     {
-        osproberOutput.append( QString::fromLocal8Bit( osprober.readAllStandardOutput() ).trimmed() );
+        // The last line may not end with a newline
+        for ( const QByteArray& rawLine : osprober.readAllStandardOutput().split( '\n' ) )
+        {
+            takeLine( rawLine );
+        }
     }
 
-    QStringList osproberCleanLines;
+    // os-prober has exited, so now the others can be mounted
     OsproberEntryList osproberEntries;
-    const auto lines = osproberOutput.split( '\n' );
-    for ( const QString& line : lines )
+    QList< QPair< int, QFuture< OsproberEntry > > > mounted;
+    for ( auto& entry : entries )
     {
-        if ( !line.simplified().isEmpty() )
+        const UnmountedOsproberEntry result = entry.result();
+        if ( result.needsMount )
         {
-            QStringList lineColumns = line.split( ':' );
-            QString prettyName;
-            if ( !lineColumns.value( 1 ).simplified().isEmpty() )
-            {
-                prettyName = lineColumns.value( 1 ).simplified();
-            }
-            else if ( !lineColumns.value( 2 ).simplified().isEmpty() )
-            {
-                prettyName = lineColumns.value( 2 ).simplified();
-            }
+            mounted.append( qMakePair( osproberEntries.count(), QtConcurrent::run( withMountedFstab, result.entry ) ) );
+        }
+        osproberEntries.append( result.entry );
+    }
+    for ( auto& entry : mounted )
+    {
+        osproberEntries[ entry.first ] = entry.second.result();
+    }
+    return osproberEntries;
+}
 
-            QString path = lineColumns.value( 0 ).simplified();
-            if ( !path.startsWith( "/dev/" ) )  //basic sanity check
-            {
-                continue;
-            }
+QFuture< OsproberEntryList >
+startOsprober()
+{
+    static QMutex mutex;
+    static QFuture< OsproberEntryList > osprober;
+    static bool started = false;
 
-            FstabEntryList fstabEntries = lookForFstabEntries( path );
-            QString homePath = findPartitionPathForMountPoint( fstabEntries, "/home" );
+    QMutexLocker lock( &mutex );
+    if ( !started )
+    {
+        osprober = QtConcurrent::run( discoverOsprober );
+        started = true;
+    }
+    return osprober;
+}
 
-            osproberEntries.append(
-                { prettyName, path, QString(), canBeResized( core, path ), lineColumns, fstabEntries, homePath } );
-            osproberCleanLines.append( line );
-        }
+OsproberEntryList
+runOsprober( PartitionCoreModule* core )
+{
+    OsproberEntryList osproberEntries = startOsprober().result();
+
+    QStringList osproberCleanLines;
+    for ( OsproberEntry& entry : osproberEntries )
+    {
+        entry.canBeResized = canBeResized( core, entry.path );
+        osproberCleanLines.append( entry.line.join( ':' ) );
     }
 
     if ( osproberCleanLines.count() > 0 )
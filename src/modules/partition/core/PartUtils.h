@@ -29,6 +29,7 @@
 #include <kpmcore/fs/filesystem.h>
 
 // Qt
+#include <QFuture>
 #include <QString>
 
 class PartitionCoreModule;
@@ -72,8 +73,21 @@ bool canBeResized( Partition* candidate );
 bool canBeResized( PartitionCoreModule* core, const QString& partitionPath );
 
 /**
- * @brief runOsprober executes os-prober, parses the output and writes relevant
- * data to GlobalStorage.
+ * @brief startOsprober runs os-prober in the background, once per session.
+ *
+ * The fstab of each OS that os-prober finds is read while os-prober
+ * is still running, if that can be done without mounting. The result
+ * is kept for the whole session, so calling this again (e.g. when the
+ * PartitionCoreModule is re-initialized) does not run os-prober again.
+ * This does not touch any PartitionCoreModule, but os-prober mounts
+ * partitions: start it after anything else that looks at them.
+ * @return the os-prober entries, without uuid and canBeResized information.
+ */
+QFuture< OsproberEntryList > startOsprober();
+
+/**
+ * @brief runOsprober waits for the results of os-prober (starting it if
+ * needed), completes them and writes relevant data to GlobalStorage.
  * @param core the PartitionCoreModule instance.
  * @return a list of os-prober entries, parsed.
  */
@@ -37,8 +37,10 @@
 #include "jobs/CreateVolumeGroupJob.h"
 #include "jobs/DeactivateVolumeGroupJob.h"
 #include "jobs/DeletePartitionJob.h"
+#include "jobs/DiscardDeviceJob.h"
 #include "jobs/FillGlobalStorageJob.h"
 #include "jobs/FormatPartitionJob.h"
+#include "jobs/ParallelDevicesJob.h"
 #include "jobs/RemoveVolumeGroupJob.h"
 #include "jobs/ResizePartitionJob.h"
 #include "jobs/ResizeVolumeGroupJob.h"
@@ -58,6 +60,7 @@
 #include <kpmcore/core/device.h>
 #include <kpmcore/core/lvmdevice.h>
 #include <kpmcore/core/partition.h>
+#include <kpmcore/core/partitiontable.h>
 #include <kpmcore/core/volumemanagerdevice.h>
 #include <kpmcore/fs/filesystemfactory.h>
 #include <kpmcore/fs/luks.h>
@@ -87,9 +90,9 @@ PartitionCoreModule::RefreshHelper::~RefreshHelper()
 class OperationHelper
 {
 public:
-    OperationHelper( PartitionModel* model, PartitionCoreModule* core )
+    OperationHelper( PartitionModel* model, PartitionCoreModule* core, Partition* partition = nullptr )
         : m_coreHelper( core )
-        , m_modelHelper( model )
+        , m_modelHelper( model, partition )
     {
     }
 
@@ -101,7 +104,7 @@ private:
     // then refresh is called. Remember that destructors are
     // called in *reverse* order of declaration in this class.
     PartitionCoreModule::RefreshHelper m_coreHelper;
-    PartitionModel::ResetHelper m_modelHelper;
+    PartitionModel::UpdateHelper m_modelHelper;
 };
 
 
@@ -185,8 +188,46 @@ PartitionCoreModule::doInit()
         cDebug() << device->deviceNode() << device->capacity() << device->name() << device->prettyName();
     }
     cDebug() << Logger::SubEntry << devices.count() << "devices detected.";
+    updateIndex();
+
+    // os-prober mounts partitions while it looks around, so start it only
+    // after KPMcore has scanned the devices (and their mount state). What
+    // follows, until runOsprober(), does not look at mounted filesystems:
+    // only the list of LVM PVs is used from the LVM scan, and os-prober
+    // can't mount a PV; the rest works on the scanned devices in memory. It only runs the
+    // first time through here: the results are kept for the session.
+    PartUtils::startOsprober();
+
+    // Asking LVM about the system is expensive, so it is only done here;
+    // after edits, the PVs are worked out from the scan and the jobs.
+    scanSystemLVM();
+
     m_deviceModel->init( devices );
 
+    DeviceList bootLoaderDevices;
+
+    for ( DeviceList::Iterator it = devices.begin(); it != devices.end(); ++it )
+        if ( ( *it )->type() != Device::Type::Disk_Device )
+        {
+            cDebug() << "Ignoring device that is not Disk_Device to bootLoaderDevices list.";
+            continue;
+        }
+        else
+        {
+            bootLoaderDevices.append( *it );
+        }
+
+    m_bootLoaderModel->init( bootLoaderDevices );
+
+    scanForLVMPVs();
+
+    //FIXME: this should be removed in favor of
+    //       proper KPM support for EFI
+    if ( PartUtils::isEfiSystem() )
+    {
+        scanForEfiSystemPartitions();
+    }
+
     // The following PartUtils::runOsprober call in turn calls PartUtils::canBeResized,
     // which relies on a working DeviceModel.
     m_osproberLines = PartUtils::runOsprober( this );
@@ -224,30 +265,6 @@ PartitionCoreModule::doInit()
     {
         deviceInfo->partitionModel->init( deviceInfo->device.data(), m_osproberLines );
     }
-
-    DeviceList bootLoaderDevices;
-
-    for ( DeviceList::Iterator it = devices.begin(); it != devices.end(); ++it )
-        if ( ( *it )->type() != Device::Type::Disk_Device )
-        {
-            cDebug() << "Ignoring device that is not Disk_Device to bootLoaderDevices list.";
-            continue;
-        }
-        else
-        {
-            bootLoaderDevices.append( *it );
-        }
-
-    m_bootLoaderModel->init( bootLoaderDevices );
-
-    scanForLVMPVs();
-
-    //FIXME: this should be removed in favor of
-    //       proper KPM support for EFI
-    if ( PartUtils::isEfiSystem() )
-    {
-        scanForEfiSystemPartitions();
-    }
 }
 
 PartitionCoreModule::~PartitionCoreModule()
@@ -301,6 +318,10 @@ PartitionCoreModule::createPartitionTable( Device* device, PartitionTable::Table
         info->forgetChanges();
 
         OperationHelper helper( partitionModelForDevice( device ), this );
+        if ( m_discardMode != DiscardDeviceJob::Mode::None && device->type() == Device::Type::Disk_Device )
+        {
+            info->jobs << Calamares::job_ptr( new DiscardDeviceJob( device, m_discardMode ) );
+        }
         CreatePartitionTableJob* job = new CreatePartitionTableJob( device, type );
         job->updatePreview();
         info->jobs << Calamares::job_ptr( job );
@@ -406,7 +427,7 @@ PartitionCoreModule::deletePartition( Device* device, Partition* partition )
     auto deviceInfo = infoForDevice( device );
     Q_ASSERT( deviceInfo );
 
-    OperationHelper helper( partitionModelForDevice( device ), this );
+    OperationHelper helper( partitionModelForDevice( device ), this, partition );
 
     if ( partition->roles().has( PartitionRole::Extended ) )
     {
@@ -492,7 +513,7 @@ PartitionCoreModule::formatPartition( Device* device, Partition* partition )
 {
     auto deviceInfo = infoForDevice( device );
     Q_ASSERT( deviceInfo );
-    OperationHelper helper( partitionModelForDevice( device ), this );
+    OperationHelper helper( partitionModelForDevice( device ), this, partition );
 
     FormatPartitionJob* job = new FormatPartitionJob( device, partition );
     deviceInfo->jobs << Calamares::job_ptr( job );
@@ -503,7 +524,7 @@ PartitionCoreModule::resizePartition( Device* device, Partition* partition, qint
 {
     auto deviceInfo = infoForDevice( device );
     Q_ASSERT( deviceInfo );
-    OperationHelper helper( partitionModelForDevice( device ), this );
+    OperationHelper helper( partitionModelForDevice( device ), this, partition );
 
     ResizePartitionJob* job = new ResizePartitionJob( device, partition, first, last );
     job->updatePreview();
@@ -515,7 +536,7 @@ PartitionCoreModule::setPartitionFlags( Device* device, Partition* partition, Pa
 {
     auto deviceInfo = infoForDevice( device );
     Q_ASSERT( deviceInfo );
-    OperationHelper( partitionModelForDevice( device ), this );
+    OperationHelper helper( partitionModelForDevice( device ), this, partition );
 
     SetPartFlagsJob* job = new SetPartFlagsJob( device, partition, flags );
     deviceInfo->jobs << Calamares::job_ptr( job );
@@ -549,11 +570,38 @@ PartitionCoreModule::jobs() const
         }
     }
 
+    // The jobs of disks next to each other in the list may run at the same
+    // time; anything else (e.g. volume groups, which depend on the PVs on
+    // the disks) runs on its own, in order.
+    QList< Calamares::JobList > diskJobs;
+    auto flushDiskJobs = [ &lst, &diskJobs ]() {
+        if ( diskJobs.count() > 1 )
+        {
+            lst << Calamares::job_ptr( new ParallelDevicesJob( diskJobs ) );
+        }
+        else if ( diskJobs.count() == 1 )
+        {
+            lst << diskJobs.first();
+        }
+        diskJobs.clear();
+    };
     for ( auto info : m_deviceInfos )
     {
-        lst << info->jobs;
+        if ( m_parallelDeviceJobs && info->device->type() == Device::Type::Disk_Device )
+        {
+            if ( !info->jobs.isEmpty() )
+            {
+                diskJobs << info->jobs;
+            }
+        }
+        else
+        {
+            flushDiskJobs();
+            lst << info->jobs;
+        }
         devices << info->device.data();
     }
+    flushDiskJobs();
     lst << Calamares::job_ptr( new FillGlobalStorageJob( devices, m_bootLoaderInstallPath ) );
 
     return lst;
@@ -620,19 +668,18 @@ PartitionCoreModule::osproberEntries() const
 }
 
 void
-PartitionCoreModule::refreshPartition( Device* device, Partition* )
+PartitionCoreModule::refreshPartition( Device* device, Partition* partition )
 {
-    // Keep it simple for now: reset the model. This can be improved to cause
-    // the model to emit dataChanged() for the affected row instead, avoiding
-    // the loss of the current selection.
+    // The partition has been changed already, so tell the model which one
     auto model = partitionModelForDevice( device );
     Q_ASSERT( model );
-    OperationHelper helper( model, this );
+    OperationHelper helper( model, this, partition );
 }
 
 void
 PartitionCoreModule::refreshAfterModelChange()
 {
+    updateIndex();
     updateHasRootMountPoint();
     updateIsDirty();
     m_bootLoaderModel->update();
@@ -651,7 +698,8 @@ void
 PartitionCoreModule::updateHasRootMountPoint()
 {
     bool oldValue = m_hasRootMountPoint;
-    m_hasRootMountPoint = findPartitionByMountPoint( "/" );
+    // The index was just updated by refreshAfterModelChange()
+    m_hasRootMountPoint = m_mountPointIndex.contains( "/" );
 
     if ( oldValue != m_hasRootMountPoint )
     {
@@ -699,29 +747,40 @@ PartitionCoreModule::scanForEfiSystemPartitions()
     m_efiSystemPartitions = efiSystemPartitions;
 }
 
+/// @brief Is @p p a LVM physical volume, possibly inside LUKS?
+static bool
+isLVMPhysicalVolume( const Partition* p )
+{
+    const FileSystem::Type type = p->fileSystem().type();
+    if ( type == FileSystem::Type::Lvm2_PV )
+    {
+        return true;
+    }
+#if defined( WITH_KPMCORE4API )
+    if ( type == FileSystem::Type::Luks || type == FileSystem::Type::Luks2 )
+#else
+    if ( type == FileSystem::Type::Luks )
+#endif
+    {
+        // Encrypted LVM PVs
+        FileSystem* innerFS = static_cast< const FS::luks* >( &p->fileSystem() )->innerFS();
+        return innerFS && innerFS->type() == FileSystem::Type::Lvm2_PV;
+    }
+    return false;
+}
+
 void
-PartitionCoreModule::scanForLVMPVs()
+PartitionCoreModule::scanSystemLVM()
 {
-    m_lvmPVs.clear();
+    m_systemLVMPVs.clear();
 
     QList< Device* > physicalDevices;
-    QList< LvmDevice* > vgDevices;
-
     for ( DeviceInfo* deviceInfo : m_deviceInfos )
     {
         if ( deviceInfo->device.data()->type() == Device::Type::Disk_Device )
         {
             physicalDevices << deviceInfo->device.data();
         }
-        else if ( deviceInfo->device.data()->type() == Device::Type::LVM_Device )
-        {
-            LvmDevice* device = dynamic_cast< LvmDevice* >( deviceInfo->device.data() );
-
-            // Restoring physical volume list
-            device->physicalVolumes().clear();
-
-            vgDevices << device;
-        }
     }
 
 #if defined( WITH_KPMCORE4API )
@@ -732,15 +791,62 @@ PartitionCoreModule::scanForLVMPVs()
     for ( auto p : LVM::pvList )
 #endif
     {
-        m_lvmPVs << p.partition().data();
+        if ( p.partition() )
+        {
+            m_systemLVMPVs.insert( p.partition()->partitionPath(), p.vgName() );
+        }
+    }
+    cDebug() << "Found" << m_systemLVMPVs.count() << "LVM physical volumes.";
+}
 
-        for ( LvmDevice* device : vgDevices )
-            if ( p.vgName() == device->name() )
+void
+PartitionCoreModule::scanForLVMPVs()
+{
+    m_lvmPVs.clear();
+
+    // PVs that were there when the system was scanned, as long as their
+    // partition is still in the proposed layout, unchanged.
+    QVector< const Partition* > systemPVs;
+    if ( !m_systemLVMPVs.isEmpty() )
+    {
+        for ( DeviceInfo* deviceInfo : m_deviceInfos )
+        {
+            Device* device = deviceInfo->device.data();
+            for ( auto it = PartitionIterator::begin( device ); it != PartitionIterator::end( device ); ++it )
             {
-                // Adding scanned VG to PV list
-                device->physicalVolumes() << p.partition();
-                break;
+                const Partition* p = *it;
+                if ( p->state() == KPM_PARTITION_STATE( None ) && m_systemLVMPVs.contains( p->partitionPath() )
+                     && isLVMPhysicalVolume( p ) )
+                {
+                    systemPVs << p;
+                }
             }
+        }
+    }
+    m_lvmPVs << systemPVs;
+
+    for ( DeviceInfo* deviceInfo : m_deviceInfos )
+    {
+        LvmDevice* device = dynamic_cast< LvmDevice* >( deviceInfo->device.data() );
+        if ( !device )
+        {
+            continue;
+        }
+        // VGs created in this session keep the PVs they were created with
+        if ( !deviceInfo->jobs.empty() && dynamic_cast< CreateVolumeGroupJob* >( deviceInfo->jobs[ 0 ].data() ) )
+        {
+            continue;
+        }
+
+        // Restoring physical volume list
+        device->physicalVolumes().clear();
+        for ( const Partition* p : systemPVs )
+        {
+            if ( m_systemLVMPVs.value( p->partitionPath() ) == device->name() )
+            {
+                device->physicalVolumes() << p;
+            }
+        }
     }
 
     for ( DeviceInfo* d : m_deviceInfos )
@@ -749,36 +855,9 @@ PartitionCoreModule::scanForLVMPVs()
         {
             // Including new LVM PVs
             CreatePartitionJob* partJob = dynamic_cast< CreatePartitionJob* >( job.data() );
-            if ( partJob )
+            if ( partJob && isLVMPhysicalVolume( partJob->partition() ) )
             {
-                Partition* p = partJob->partition();
-
-                if ( p->fileSystem().type() == FileSystem::Type::Lvm2_PV )
-                {
-                    m_lvmPVs << p;
-                }
-                else if ( p->fileSystem().type() == FileSystem::Type::Luks )
-                {
-                    // Encrypted LVM PVs
-                    FileSystem* innerFS = static_cast< const FS::luks* >( &p->fileSystem() )->innerFS();
-
-                    if ( innerFS && innerFS->type() == FileSystem::Type::Lvm2_PV )
-                    {
-                        m_lvmPVs << p;
-                    }
-                }
-#if defined( WITH_KPMCORE4API )
-                else if ( p->fileSystem().type() == FileSystem::Type::Luks2 )
-                {
-                    // Encrypted LVM PVs
-                    FileSystem* innerFS = static_cast< const FS::luks* >( &p->fileSystem() )->innerFS();
-
-                    if ( innerFS && innerFS->type() == FileSystem::Type::Lvm2_PV )
-                    {
-                        m_lvmPVs << p;
-                    }
-                }
-#endif
+                m_lvmPVs << partJob->partition();
             }
         }
     }
@@ -787,23 +866,21 @@ PartitionCoreModule::scanForLVMPVs()
 PartitionCoreModule::DeviceInfo*
 PartitionCoreModule::infoForDevice( const Device* device ) const
 {
-    for ( auto it = m_deviceInfos.constBegin(); it != m_deviceInfos.constEnd(); ++it )
-    {
-        if ( ( *it )->device.data() == device )
-        {
-            return *it;
-        }
-        if ( ( *it )->immutableDevice.data() == device )
-        {
-            return *it;
-        }
-    }
-    return nullptr;
+    return m_deviceIndex.value( device, nullptr );
 }
 
 Partition*
 PartitionCoreModule::findPartitionByMountPoint( const QString& mountPoint ) const
 {
+    // Mount points can be set without telling the model (e.g. for the
+    // EFI system partition), so check the index and search if it's stale.
+    // A partition deleted since the index was built is null here.
+    Partition* partition = m_mountPointIndex.value( mountPoint ).data();
+    if ( partition && PartitionInfo::mountPoint( partition ) == mountPoint )
+    {
+        return partition;
+    }
+
     for ( auto deviceInfo : m_deviceInfos )
     {
         Device* device = deviceInfo->device.data();
@@ -816,6 +893,42 @@ PartitionCoreModule::findPartitionByMountPoint( const QString& mountPoint ) cons
     return nullptr;
 }
 
+Partition*
+PartitionCoreModule::findPartitionByPath( const QString& path ) const
+{
+    return m_pathIndex.value( path.simplified() ).data();
+}
+
+void
+PartitionCoreModule::updateIndex()
+{
+    m_deviceIndex.clear();
+    m_pathIndex.clear();
+    m_mountPointIndex.clear();
+
+    for ( DeviceInfo* deviceInfo : m_deviceInfos )
+    {
+        Device* device = deviceInfo->device.data();
+        m_deviceIndex.insert( device, deviceInfo );
+        m_deviceIndex.insert( deviceInfo->immutableDevice.data(), deviceInfo );
+
+        for ( auto it = PartitionIterator::begin( device ); it != PartitionIterator::end( device ); ++it )
+        {
+            // Like the searches, the first partition found wins
+            const QString path = ( *it )->partitionPath();
+            if ( !path.isEmpty() && !m_pathIndex.contains( path ) )
+            {
+                m_pathIndex.insert( path, *it );
+            }
+            const QString mountPoint = PartitionInfo::mountPoint( *it );
+            if ( !mountPoint.isEmpty() && !m_mountPointIndex.contains( mountPoint ) )
+            {
+                m_mountPointIndex.insert( mountPoint, *it );
+            }
+        }
+    }
+}
+
 void
 PartitionCoreModule::setBootLoaderInstallPath( const QString& path )
 {
@@ -983,6 +1096,7 @@ PartitionCoreModule::revertAllDevices()
                     m_deviceModel->removeDevice( ( *it )->device.data() );
 
                     it = m_deviceInfos.erase( it );
+                    updateIndex();
 
                     continue;
                 }
@@ -1008,12 +1122,30 @@ PartitionCoreModule::revertDevice( Device* dev, bool individualRevert )
         return;
     }
     devInfo->forgetChanges();
-    CoreBackend* backend = CoreBackendManager::self()->backend();
-    Device* newDev = backend->scanDevice( devInfo->device->deviceNode() );
-    devInfo->device.reset( newDev );
-    devInfo->partitionModel->init( newDev, m_osproberLines );
 
-    m_deviceModel->swapDevice( dev, newDev );
+    Device* newDev = dev;
+    // The immutable copy is the state of the disk as it was scanned,
+    // so restore the partition table from there instead of asking the
+    // hardware again. The Device itself stays, so that pointers to it
+    // (e.g. in the DeviceModel) remain valid.
+    if ( dev->type() == Device::Type::Disk_Device
+         && KPMHelpers::restorePartitionTable( dev, devInfo->immutableDevice->partitionTable() ) )
+    {
+        devInfo->partitionModel->init( dev, m_osproberLines );
+    }
+    else
+    {
+        // Volume groups have more state than just the partition table,
+        // and so do LUKS partitions
+        CoreBackend* backend = CoreBackendManager::self()->backend();
+        newDev = backend->scanDevice( devInfo->device->deviceNode() );
+        devInfo->device.reset( newDev );
+        devInfo->partitionModel->init( newDev, m_osproberLines );
+
+        m_deviceModel->swapDevice( dev, newDev );
+    }
+    // The old partitions are gone
+    updateIndex();
 
     QList< Device* > devices;
     for ( DeviceInfo* const info : m_deviceInfos )
@@ -25,6 +25,8 @@
 #include "core/PartitionLayout.h"
 #include "core/PartitionModel.h"
 
+#include "jobs/DiscardDeviceJob.h"
+
 #include "Job.h"
 #include "partition/KPMManager.h"
 
@@ -33,9 +35,11 @@
 #include <kpmcore/core/partitiontable.h>
 
 // Qt
+#include <QHash>
 #include <QList>
 #include <QMutex>
 #include <QObject>
+#include <QPointer>
 
 #include <functional>
 
@@ -163,6 +167,20 @@ public:
     /// @brief Set the path where the bootloader will be installed
     void setBootLoaderInstallPath( const QString& path );
 
+    /** @brief Run the jobs for different disks at the same time?
+     *
+     * When set, jobs() puts the jobs of (consecutive) disks into a
+     * single ParallelDevicesJob. Default off.
+     */
+    void setParallelDeviceJobs( bool parallel ) { m_parallelDeviceJobs = parallel; }
+
+    /** @brief Discard all data on a disk before creating a new partition table?
+     *
+     * When not None, createPartitionTable() adds a DiscardDeviceJob
+     * before the job that creates the table. Default None.
+     */
+    void setDiscardMode( DiscardDeviceJob::Mode mode ) { m_discardMode = mode; }
+
     void initLayout();
     void initLayout( const QVariantList& config );
 
@@ -201,10 +219,21 @@ public:
      */
     Partition* findPartitionByMountPoint( const QString& mountPoint ) const;
 
+    /**
+     * @brief findPartitionByPath returns a Partition* for a given device path.
+     * @param path the device path (e.g. /dev/sda1) of the partition.
+     * @return a pointer to a Partition object, or nullptr.
+     * Like findPartitionByMountPoint(), this looks in the live devices.
+     */
+    Partition* findPartitionByPath( const QString& path ) const;
+
     void revert();  // full revert, thread safe, calls doInit
     void revertAllDevices();  // convenience function, calls revertDevice
-    /** @brief rescans a single Device and updates DeviceInfo
+    /** @brief restores a single Device to its original state and updates DeviceInfo
      *
+     * For disks, the partition table is restored from the immutable
+     * copy taken when the disk was scanned; other devices, and disks
+     * with LUKS partitions, are rescanned.
      * When @p individualRevert is true, calls refreshAfterModelChange(),
      * used to reduce number of refreshes when calling revertAllDevices().
      */
@@ -266,18 +295,35 @@ private:
     QList< DeviceInfo* > m_deviceInfos;
     QList< Partition* > m_efiSystemPartitions;
     QVector< const Partition* > m_lvmPVs;
+    /** Lookups for infoForDevice() and the find*() methods, see updateIndex()
+     *
+     * The partitions are guarded, so that one that is deleted before
+     * the next updateIndex() is not handed out (it is null then).
+     */
+    QHash< const Device*, DeviceInfo* > m_deviceIndex;
+    QHash< QString, QPointer< Partition > > m_pathIndex;
+    QHash< QString, QPointer< Partition > > m_mountPointIndex;
+    /// Partition path -> VG name, of the PVs found when the devices were scanned
+    QHash< QString, QString > m_systemLVMPVs;
 
     DeviceModel* m_deviceModel;
     BootLoaderModel* m_bootLoaderModel;
     bool m_hasRootMountPoint = false;
     bool m_isDirty = false;
+    bool m_parallelDeviceJobs = false;
+    DiscardDeviceJob::Mode m_discardMode = DiscardDeviceJob::Mode::None;
     QString m_bootLoaderInstallPath;
     PartitionLayout* m_partLayout;
 
     void doInit();
+    /// @brief Rebuilds the lookups, after devices or partitions change
+    void updateIndex();
     void updateHasRootMountPoint();
     void updateIsDirty();
     void scanForEfiSystemPartitions();
+    /// @brief Asks LVM for the PVs on the system (slow), fills m_systemLVMPVs
+    void scanSystemLVM();
+    /// @brief Updates m_lvmPVs (and VG PV lists) from m_systemLVMPVs and the jobs
     void scanForLVMPVs();
 
     DeviceInfo* infoForDevice( const Device* ) const;
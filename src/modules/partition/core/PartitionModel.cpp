@@ -38,6 +38,7 @@
 
 // Qt
 #include <QColor>
+#include <QThread>
 
 using CalamaresUtils::Partition::isPartitionFreeSpace;
 using CalamaresUtils::Partition::isPartitionNew;
@@ -52,6 +53,7 @@ PartitionModel::ResetHelper::ResetHelper( PartitionModel* model )
 
 PartitionModel::ResetHelper::~ResetHelper()
 {
+    m_model->loadRows();
     // We need to unlock the mutex before emitting the reset signal,
     // because the reset will cause clients to start looking at the
     // (new) data.
@@ -59,6 +61,67 @@ PartitionModel::ResetHelper::~ResetHelper()
     m_model->endResetModel();
 }
 
+//- UpdateHelper -------------------------------------------
+
+/// @brief What the views show of @p partition, to see if a row has changed
+static QVariantList
+rowState( Partition* partition )
+{
+    return { partition->firstSector(),
+             partition->lastSector(),
+             int( partition->state() ),
+             int( partition->fileSystem().type() ),
+             partition->fileSystem().label(),
+             partition->fileSystem().uuid(),
+             partition->partitionPath(),
+             PartitionInfo::mountPoint( partition ),
+             PartitionInfo::format( partition ),
+             int( PartitionInfo::flags( partition ) ) };
+}
+
+PartitionModel::UpdateHelper::UpdateHelper( PartitionModel* model, Partition* changed )
+    : m_model( model )
+{
+    if ( m_model->m_updateDepth++ == 0 )
+    {
+        // Row signals from another thread reach the views late (queued),
+        // when the rows they name are already gone; a reset doesn't care.
+        m_model->m_resetting = QThread::currentThread() != m_model->thread();
+        if ( m_model->m_resetting )
+        {
+            m_model->m_lock.lock();
+            m_model->beginResetModel();
+            return;
+        }
+        for ( auto it = m_model->m_parents.cbegin(); it != m_model->m_parents.cend(); ++it )
+        {
+            m_model->m_snapshot.insert( it.key(), rowState( it.key() ) );
+        }
+    }
+    if ( changed )
+    {
+        m_model->m_changed.insert( changed );
+    }
+}
+
+PartitionModel::UpdateHelper::~UpdateHelper()
+{
+    if ( --m_model->m_updateDepth == 0 )
+    {
+        if ( m_model->m_resetting )
+        {
+            m_model->m_changed.clear();
+            m_model->loadRows();
+            m_model->m_lock.unlock();
+            m_model->endResetModel();
+        }
+        else
+        {
+            m_model->updateRows();
+        }
+    }
+}
+
 //- PartitionModel -----------------------------------------
 PartitionModel::PartitionModel( QObject* parent )
     : QAbstractItemModel( parent )
@@ -73,6 +136,7 @@ PartitionModel::init( Device* device, const OsproberEntryList& osproberEntries )
     beginResetModel();
     m_device = device;
     m_osproberEntries = osproberEntries;
+    loadRows();
     endResetModel();
 }
 
@@ -85,26 +149,18 @@ PartitionModel::columnCount( const QModelIndex& ) const
 int
 PartitionModel::rowCount( const QModelIndex& parent ) const
 {
-    Partition* parentPartition = partitionForIndex( parent );
-    if ( parentPartition )
-    {
-        return parentPartition->children().count();
-    }
-    PartitionTable* table = m_device->partitionTable();
-    return table ? table->children().count() : 0;
+    QMutexLocker lock( &m_lock );
+    Partition* parentPartition = parent.isValid() ? static_cast< Partition* >( parent.internalPointer() ) : nullptr;
+    return m_rows.value( parentPartition ).count();
 }
 
 QModelIndex
 PartitionModel::index( int row, int column, const QModelIndex& parent ) const
 {
-    PartitionNode* parentPartition = parent.isValid() ? static_cast< PartitionNode* >( partitionForIndex( parent ) )
-                                                      : static_cast< PartitionNode* >( m_device->partitionTable() );
-    if ( !parentPartition )
-    {
-        return QModelIndex();
-    }
-    auto lst = parentPartition->children();
-    if ( row < 0 || row >= lst.count() )
+    QMutexLocker lock( &m_lock );
+    Partition* parentPartition = parent.isValid() ? static_cast< Partition* >( parent.internalPointer() ) : nullptr;
+    const Rows rows = m_rows.value( parentPartition );
+    if ( row < 0 || row >= rows.count() )
     {
         return QModelIndex();
     }
@@ -112,8 +168,7 @@ PartitionModel::index( int row, int column, const QModelIndex& parent ) const
     {
         return QModelIndex();
     }
-    Partition* partition = parentPartition->children().at( row );
-    return createIndex( row, column, partition );
+    return createIndex( row, column, rows.at( row ) );
 }
 
 QModelIndex
@@ -123,28 +178,24 @@ PartitionModel::parent( const QModelIndex& child ) const
     {
         return QModelIndex();
     }
-    Partition* partition = partitionForIndex( child );
+    QMutexLocker lock( &m_lock );
+    return indexForRow( m_parents.value( static_cast< Partition* >( child.internalPointer() ) ) );
+}
+
+QModelIndex
+PartitionModel::indexForRow( Partition* partition ) const
+{
     if ( !partition )
     {
         return QModelIndex();
     }
-    PartitionNode* parentNode = partition->parent();
-    if ( parentNode == m_device->partitionTable() )
+    const int row = m_rows.value( m_parents.value( partition ) ).indexOf( partition );
+    if ( row < 0 )
     {
+        cWarning() << "No parent found!";
         return QModelIndex();
     }
-
-    int row = 0;
-    for ( auto p : m_device->partitionTable()->children() )
-    {
-        if ( parentNode == p )
-        {
-            return createIndex( row, 0, parentNode );
-        }
-        ++row;
-    }
-    cWarning() << "No parent found!";
-    return QModelIndex();
+    return createIndex( row, 0, partition );
 }
 
 QVariant
@@ -323,7 +374,9 @@ PartitionModel::partitionForIndex( const QModelIndex& index ) const
     {
         return nullptr;
     }
-    return reinterpret_cast< Partition* >( index.internalPointer() );
+    Partition* partition = reinterpret_cast< Partition* >( index.internalPointer() );
+    // Stale partitions may have been deleted already
+    return m_stale.contains( partition ) ? nullptr : partition;
 }
 
 
@@ -332,3 +385,212 @@ PartitionModel::update()
 {
     emit dataChanged( index( 0, 0 ), index( rowCount() - 1, columnCount() - 1 ) );
 }
+
+void
+PartitionModel::loadRows()
+{
+    m_rows.clear();
+    m_parents.clear();
+    m_stale.clear();
+
+    PartitionTable* table = m_device ? m_device->partitionTable() : nullptr;
+    if ( table )
+    {
+        setRows( nullptr, Rows::fromList( table->children() ) );
+    }
+}
+
+void
+PartitionModel::setRows( Partition* parent, const Rows& rows )
+{
+    m_rows.insert( parent, rows );
+    for ( Partition* partition : rows )
+    {
+        m_parents.insert( partition, parent );
+        if ( !partition->children().isEmpty() )
+        {
+            setRows( partition, Rows::fromList( partition->children() ) );
+        }
+    }
+}
+
+void
+PartitionModel::forgetRow( Partition* partition )
+{
+    for ( Partition* child : m_rows.value( partition ) )
+    {
+        forgetRow( child );
+    }
+    m_rows.remove( partition );
+    m_parents.remove( partition );
+}
+
+/// @brief Collects the rows that the device has now, under each parent
+static void
+liveRows( Partition* parent, PartitionNode* node, QHash< Partition*, QVector< Partition* > >& rows )
+{
+    const auto children = QVector< Partition* >::fromList( node->children() );
+    rows.insert( parent, children );
+    for ( Partition* partition : children )
+    {
+        if ( !partition->children().isEmpty() )
+        {
+            liveRows( partition, partition, rows );
+        }
+    }
+}
+
+void
+PartitionModel::updateRows()
+{
+    QHash< Partition*, Rows > live;
+    PartitionTable* table = m_device ? m_device->partitionTable() : nullptr;
+    if ( table )
+    {
+        liveRows( nullptr, table, live );
+    }
+
+    {
+        QSet< Partition* > livePartitions;
+        for ( const Rows& rows : live )
+        {
+            for ( Partition* partition : rows )
+            {
+                livePartitions.insert( partition );
+            }
+        }
+
+        QMutexLocker lock( &m_lock );
+        for ( auto it = m_parents.cbegin(); it != m_parents.cend(); ++it )
+        {
+            if ( !livePartitions.contains( it.key() ) )
+            {
+                m_stale.insert( it.key() );
+            }
+        }
+    }
+
+    // Removals first, so that the rows which are left are in the same
+    // order as on the device, and then the insertions in between.
+    const auto parents = m_rows.keys();
+    for ( Partition* parent : parents )
+    {
+        if ( m_rows.contains( parent ) )
+        {
+            removeRows( parent, live.value( parent ) );
+        }
+    }
+    insertRows( nullptr, live.value( nullptr ) );
+    for ( auto it = live.cbegin(); it != live.cend(); ++it )
+    {
+        if ( it.key() )
+        {
+            insertRows( it.key(), it.value() );
+        }
+    }
+
+    // Rows that were there before, and still are, may have changed
+    for ( auto it = m_snapshot.cbegin(); it != m_snapshot.cend(); ++it )
+    {
+        Partition* partition = it.key();
+        if ( m_parents.contains( partition )
+             && ( m_changed.contains( partition ) || rowState( partition ) != it.value() ) )
+        {
+            const QModelIndex first = indexForRow( partition );
+            emit dataChanged( first, first.sibling( first.row(), ColumnCount - 1 ) );
+        }
+    }
+
+    QMutexLocker lock( &m_lock );
+    m_stale.clear();
+    m_snapshot.clear();
+    m_changed.clear();
+}
+
+void
+PartitionModel::removeRows( Partition* parent, const Rows& newRows )
+{
+    const Rows rows = m_rows.value( parent );
+
+    // Keep the rows that are still under this parent, as long as they
+    // are in the same order as on the device
+    QVector< bool > keep( rows.count(), false );
+    int next = 0;
+    for ( int i = 0; i < rows.count(); ++i )
+    {
+        const int at = newRows.indexOf( rows.at( i ), next );
+        if ( at >= 0 )
+        {
+            keep[ i ] = true;
+            next = at + 1;
+        }
+    }
+
+    // Back to front, removing each run of rows at once
+    for ( int last = rows.count() - 1; last >= 0; )
+    {
+        if ( keep.at( last ) )
+        {
+            --last;
+            continue;
+        }
+        int first = last;
+        while ( first > 0 && !keep.at( first - 1 ) )
+        {
+            --first;
+        }
+
+        beginRemoveRows( indexForRow( parent ), first, last );
+        {
+            QMutexLocker lock( &m_lock );
+            for ( int i = first; i <= last; ++i )
+            {
+                forgetRow( rows.at( i ) );
+            }
+            m_rows[ parent ].remove( first, last - first + 1 );
+        }
+        endRemoveRows();
+        last = first - 1;
+    }
+}
+
+void
+PartitionModel::insertRows( Partition* parent, const Rows& newRows )
+{
+    // After removeRows(), the rows are a subsequence of newRows
+    int i = 0;
+    while ( i < newRows.count() )
+    {
+        const Rows rows = m_rows.value( parent );
+        if ( i < rows.count() && rows.at( i ) == newRows.at( i ) )
+        {
+            ++i;
+            continue;
+        }
+
+        // New rows from i up to the next row that is already there
+        Partition* nextRow = i < rows.count() ? rows.at( i ) : nullptr;
+        int end = i;
+        while ( end < newRows.count() && newRows.at( end ) != nextRow )
+        {
+            ++end;
+        }
+
+        beginInsertRows( indexForRow( parent ), i, end - 1 );
+        {
+            QMutexLocker lock( &m_lock );
+            for ( int j = i; j < end; ++j )
+            {
+                Partition* partition = newRows.at( j );
+                m_rows[ parent ].insert( j, partition );
+                m_parents.insert( partition, parent );
+                if ( !partition->children().isEmpty() )
+                {
+                    setRows( partition, Rows::fromList( partition->children() ) );
+                }
+            }
+        }
+        endInsertRows();
+        i = end;
+    }
+}
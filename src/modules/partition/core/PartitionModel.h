@@ -23,7 +23,11 @@
 
 // Qt
 #include <QAbstractItemModel>
+#include <QHash>
 #include <QMutex>
+#include <QSet>
+#include <QVariantList>
+#include <QVector>
 
 class Device;
 class Partition;
@@ -39,9 +43,14 @@ class PartitionNode;
  * The Device class does not notify the outside world of changes on the
  * Partition objects it owns. Since a Qt model must notify its views *before*
  * and *after* making changes, it is important to make use of
- * the PartitionModel::ResetHelper class to wrap changes.
+ * the PartitionModel::UpdateHelper (or ResetHelper) class to wrap changes.
  *
  * This is what PartitionCoreModule does when it create jobs.
+ *
+ * The model keeps its own copy of the structure of the partition tree
+ * (which partitions are in which rows); this is what the views see.
+ * After a change, it is compared to the device, so that the model can
+ * tell the views which rows were removed, inserted and changed.
  */
 class PartitionModel : public QAbstractItemModel
 {
@@ -66,6 +75,33 @@ public:
         PartitionModel* m_model;
     };
 
+    /**
+     * This helper class must be instantiated on the stack *before* making
+     * changes to the device represented by this model. When it is destructed,
+     * the model compares the device with the rows it had, and emits
+     * row-level signals (rows removed, rows inserted, data changed) for
+     * the differences, instead of resetting the whole model. The
+     * @p changed partition, if any, is always reported as changed, since
+     * some changes (e.g. of the mount point) may have been made already.
+     *
+     * Helpers may be nested; only the outermost one updates the views.
+     *
+     * When the change is made from a thread other than the model's,
+     * this works like a ResetHelper instead.
+     */
+    class UpdateHelper
+    {
+    public:
+        UpdateHelper( PartitionModel* model, Partition* changed = nullptr );
+        ~UpdateHelper();
+
+        UpdateHelper( const UpdateHelper& ) = delete;
+        UpdateHelper& operator=( const UpdateHelper& ) = delete;
+
+    private:
+        PartitionModel* m_model;
+    };
+
     enum
     {
         // The raw size, as a qlonglong. This is different from the DisplayRole of
@@ -115,10 +151,35 @@ public:
 
 private:
     friend class ResetHelper;
+    friend class UpdateHelper;
+
+    using Rows = QVector< Partition* >;
+
+    /// @brief Makes the rows match the device, without telling the views
+    void loadRows();
+    /// @brief Sets the rows under @p parent (and their children, recursively)
+    void setRows( Partition* parent, const Rows& rows );
+    /// @brief Drops @p partition (and its children) from the rows
+    void forgetRow( Partition* partition );
+    /// @brief Makes the rows match the device, telling the views what changed
+    void updateRows();
+    void removeRows( Partition* parent, const Rows& newRows );
+    void insertRows( Partition* parent, const Rows& newRows );
+    /// @brief Index (in column 0) of @p partition; the invalid index for nullptr
+    QModelIndex indexForRow( Partition* partition ) const;
 
     Device* m_device;
     OsproberEntryList m_osproberEntries;
     mutable QMutex m_lock;
+
+    QHash< Partition*, Rows > m_rows;  ///< Rows under each partition (under nullptr for the partition table)
+    QHash< Partition*, Partition* > m_parents;  ///< Parent of each partition in the rows
+    QSet< Partition* > m_stale;  ///< Removed from the device, not (yet) from the rows
+
+    int m_updateDepth = 0;
+    bool m_resetting = false;  ///< The outermost UpdateHelper resets the model
+    QHash< Partition*, QVariantList > m_snapshot;  ///< State of each row before an update
+    QSet< Partition* > m_changed;
 };
 
 #endif /* PARTITIONMODEL_H */
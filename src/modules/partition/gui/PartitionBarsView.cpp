@@ -519,6 +519,25 @@ PartitionBarsView::updateGeometries()
 }
 
 
+void
+PartitionBarsView::rowsInserted( const QModelIndex& parent, int start, int end )
+{
+    QAbstractItemView::rowsInserted( parent, start, end );
+    updateGeometry();
+    viewport()->update();
+}
+
+
+void
+PartitionBarsView::rowsAboutToBeRemoved( const QModelIndex& parent, int start, int end )
+{
+    QAbstractItemView::rowsAboutToBeRemoved( parent, start, end );
+    // The repaint happens later, once the rows are gone
+    updateGeometry();
+    viewport()->update();
+}
+
+
 QPair< QVector< PartitionBarsView::Item >, qreal >
 PartitionBarsView::computeItemsVector( const QModelIndex& parent ) const
 {
@@ -621,3 +621,22 @@ PartitionLabelsView::updateGeometries()
 {
     updateGeometry(); //get a new rect() for redrawing all the labels
 }
+
+
+void
+PartitionLabelsView::rowsInserted( const QModelIndex& parent, int start, int end )
+{
+    QAbstractItemView::rowsInserted( parent, start, end );
+    updateGeometry();
+    viewport()->update();
+}
+
+
+void
+PartitionLabelsView::rowsAboutToBeRemoved( const QModelIndex& parent, int start, int end )
+{
+    QAbstractItemView::rowsAboutToBeRemoved( parent, start, end );
+    // The repaint happens later, once the rows are gone
+    updateGeometry();
+    viewport()->update();
+}
@@ -73,6 +73,9 @@ protected:
 
 protected slots:
     void updateGeometries() override;
+    // Edits insert and remove rows without resetting the model
+    void rowsInserted( const QModelIndex& parent, int start, int end ) override;
+    void rowsAboutToBeRemoved( const QModelIndex& parent, int start, int end ) override;
 
 private:
     QRect labelsRect() const;
@@ -583,14 +583,24 @@ PartitionPage::updateFromCurrentDevice()
         updateButtons();
     } );
     connect( model, &QAbstractItemModel::modelReset, this, &PartitionPage::onPartitionModelReset );
+    // Edits only touch the rows that change, without a reset
+    connect( model, &QAbstractItemModel::rowsInserted, this, &PartitionPage::onPartitionModelChanged );
+    connect( model, &QAbstractItemModel::rowsRemoved, this, &PartitionPage::onPartitionModelChanged );
+    connect( model, &QAbstractItemModel::dataChanged, this, &PartitionPage::onPartitionModelChanged );
 }
 
 void
 PartitionPage::onPartitionModelReset()
+{
+    onPartitionModelChanged();
+    updateBootLoaderIndex();
+}
+
+void
+PartitionPage::onPartitionModelChanged()
 {
     m_ui->partitionTreeView->expandAll();
     updateButtons();
-    updateBootLoaderIndex();
 }
 
 void
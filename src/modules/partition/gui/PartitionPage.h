@@ -74,6 +74,7 @@ private:
     void onDeleteClicked();
     void onPartitionViewActivated();
     void onPartitionModelReset();
+    void onPartitionModelChanged();
 
     void updatePartitionToCreate( Device*, Partition* );
     void editExistingPartition( Device*, Partition* );
@@ -652,6 +652,21 @@ PartitionViewStep::setConfigurationMap( const QVariantMap& configurationMap )
                 CalamaresUtils::getBool( configurationMap, "enableLuksAutomatedPartitioning", true ) );
     gs->insert( "allowManualPartitioning",
                 CalamaresUtils::getBool( configurationMap, "allowManualPartitioning", true ) );
+    m_core->setParallelDeviceJobs( CalamaresUtils::getBool( configurationMap, "parallelDeviceJobs", false ) );
+    if ( configurationMap.contains( "discardDevice" ) )
+    {
+        bool ok = false;
+        const QString discardName = CalamaresUtils::getString( configurationMap, "discardDevice" );
+        const auto discardMode = DiscardDeviceJob::nameToMode( discardName, ok );
+        if ( ok )
+        {
+            m_core->setDiscardMode( discardMode );
+        }
+        else
+        {
+            cWarning() << "Partition-module setting *discardDevice* is bad (" << discardName << "), not discarding.";
+        }
+    }
 
     // The defaultFileSystemType setting needs a bit more processing,
     // as we want to cover various cases (such as different cases)
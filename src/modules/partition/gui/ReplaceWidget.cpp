@@ -372,6 +372,10 @@ ReplaceWidget::updateFromCurrentDevice( QComboBox* devicesComboBox )
              this, &ReplaceWidget::onPartitionViewActivated );
 
     connect( model, &QAbstractItemModel::modelReset, this, &ReplaceWidget::onPartitionModelReset );
+    // Edits only touch the rows that change, without a reset
+    connect( model, &QAbstractItemModel::rowsInserted, this, &ReplaceWidget::onPartitionModelReset );
+    connect( model, &QAbstractItemModel::rowsRemoved, this, &ReplaceWidget::onPartitionModelReset );
+    connect( model, &QAbstractItemModel::dataChanged, this, &ReplaceWidget::onPartitionModelReset );
 }
 
 
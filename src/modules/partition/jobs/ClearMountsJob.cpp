@@ -1,7 +1,7 @@
 /* === This file is part of Calamares - <https://github.com/calamares> ===
  *
  *   Copyright 2014-2015, Teo Mrnjavac <teo@kde.org>
- *   Copyright 2018, Adriaan de Groot <groot@kde.org>
+ *   Copyright 2018, 2020, Adriaan de Groot <groot@kde.org>
  *   Copyright 2019, Kevin Kofler <kevin.kofler@chello.at>
  *
  *   Calamares is free software: you can redistribute it and/or modify
@@ -32,8 +32,23 @@
 #include <kpmcore/util/report.h>
 
 #include <QDir>
-#include <QProcess>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
 #include <QStringList>
+#include <QTextStream>
+
+#include <fcntl.h>
+#include <linux/dm-ioctl.h>
+#include <sys/ioctl.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <sys/swap.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
 
 using CalamaresUtils::Partition::PartitionIterator;
 
@@ -89,233 +104,313 @@ getPartitionsForDevice( const QString& deviceName )
     return partitions;
 }
 
-Calamares::JobResult
-ClearMountsJob::exec()
+/// @brief Undo the octal escapes (e.g. \040 for space) in /proc/self/mountinfo and /proc/swaps
+static QString
+unescapeProcField( const QByteArray& field )
 {
-    CalamaresUtils::Partition::Syncer s;
-
-    QString deviceName = m_device->deviceNode().split( '/' ).last();
-
-    QStringList goodNews;
-    QProcess process;
-
-    QStringList partitionsList = getPartitionsForDevice( deviceName );
-
-    // Build a list of partitions of type 82 (Linux swap / Solaris).
-    // We then need to clear them just in case they contain something resumable from a
-    // previous suspend-to-disk.
-    QStringList swapPartitions;
-    process.start( "sfdisk", { "-d", m_device->deviceNode() } );
-    process.waitForFinished();
-    // Sample output:
-    //    % sudo sfdisk -d /dev/sda
-    //    label: dos
-    //    label-id: 0x000ced89
-    //    device: /dev/sda
-    //    unit: sectors
-
-    //    /dev/sda1 : start=          63, size=    29329345, type=83, bootable
-    //    /dev/sda2 : start=    29331456, size=     2125824, type=82
-
-    swapPartitions = QString::fromLocal8Bit( process.readAllStandardOutput() ).split( '\n' );
-    swapPartitions = swapPartitions.filter( "type=82" );
-    for ( QStringList::iterator it = swapPartitions.begin(); it != swapPartitions.end(); ++it )
+    QByteArray result;
+    result.reserve( field.size() );
+    for ( int i = 0; i < field.size(); ++i )
     {
-        *it = ( *it ).simplified().split( ' ' ).first();
-    }
-
-    const QStringList cryptoDevices = getCryptoDevices();
-    for ( const QString& mapperPath : cryptoDevices )
-    {
-        tryUmount( mapperPath );
-        QString news = tryCryptoClose( mapperPath );
-        if ( !news.isEmpty() )
+        if ( field[ i ] == '\\' && i + 3 < field.size() )
         {
-            goodNews.append( news );
-        }
-    }
-
-    // First we umount all LVM logical volumes we can find
-    process.start( "lvscan", { "-a" } );
-    process.waitForFinished();
-    if ( process.exitCode() == 0 )  //means LVM2 tools are installed
-    {
-        const QStringList lvscanLines = QString::fromLocal8Bit( process.readAllStandardOutput() ).split( '\n' );
-        for ( const QString& lvscanLine : lvscanLines )
-        {
-            QString lvPath = lvscanLine.simplified().split( ' ' ).value( 1 );  //second column
-            lvPath = lvPath.replace( '\'', "" );
-
-            QString news = tryUmount( lvPath );
-            if ( !news.isEmpty() )
+            bool ok = false;
+            const int c = field.mid( i + 1, 3 ).toInt( &ok, 8 );
+            if ( ok )
             {
-                goodNews.append( news );
+                result.append( char( c ) );
+                i += 3;
+                continue;
             }
         }
+        result.append( field[ i ] );
     }
-    else
+    return QString::fromLocal8Bit( result );
+}
+
+/// @brief Does the block device at @p path (e.g. /dev/mapper/x) belong to @p devicePaths ?
+static bool
+isOneOf( const QString& path, const QSet< QString >& devicePaths )
+{
+    if ( devicePaths.contains( path ) )
     {
-        cWarning() << "this system does not seem to have LVM2 tools.";
+        return true;
     }
+    // Symlinks like /dev/mapper/* point to the /dev/dm-* nodes
+    const QString canonical = QFileInfo( path ).canonicalFilePath();
+    return !canonical.isEmpty() && devicePaths.contains( canonical );
+}
 
-    // Then we go looking for volume groups that use this device for physical volumes
-    process.start( "pvdisplay", { "-C", "--noheadings" } );
-    process.waitForFinished();
-    if ( process.exitCode() == 0 )  //means LVM2 tools are installed
+/** @brief The mount points of the filesystems on the given devices
+ *
+ * The @p mountinfo is the contents of /proc/self/mountinfo. A filesystem
+ * is on one of the devices if its device number ("8:1") is in @p deviceNumbers
+ * or its source (e.g. "/dev/sda1") is in @p devicePaths. The mount points
+ * are returned in the order they should be unmounted, last-mounted first.
+ */
+QStringList
+getMountPointsForDevices( const QByteArray& mountinfo,
+                          const QSet< QString >& devicePaths,
+                          const QSet< QString >& deviceNumbers )
+{
+    QStringList mountPoints;
+    for ( const QByteArray& line : mountinfo.split( '\n' ) )
     {
-        QString pvdisplayOutput = process.readAllStandardOutput();
-        if ( !pvdisplayOutput.simplified().isEmpty() )  //means there is at least one LVM PV
+        // 36 35 98:0 /mnt1 /mnt2 rw,noatime master:1 - ext3 /dev/root rw,errors=continue
+        const QList< QByteArray > fields = line.split( ' ' );
+        const int separator = fields.indexOf( "-" );
+        if ( fields.count() < 5 || separator < 0 || separator + 2 >= fields.count() )
         {
-            QSet< QString > vgSet;
-
-            const QStringList pvdisplayLines = pvdisplayOutput.split( '\n' );
-            for ( const QString& pvdisplayLine : pvdisplayLines )
-            {
-                QString pvPath = pvdisplayLine.simplified().split( ' ' ).value( 0 );
-                QString vgName = pvdisplayLine.simplified().split( ' ' ).value( 1 );
-                if ( !pvPath.contains( deviceName ) )
-                {
-                    continue;
-                }
-
-                vgSet.insert( vgName );
-            }
-
-            foreach ( const QString& vgName, vgSet )
-            {
-                process.start( "vgchange", { "-an", vgName } );
-                process.waitForFinished();
-                if ( process.exitCode() == 0 )
-                {
-                    goodNews.append( QString( "Successfully disabled volume group %1." ).arg( vgName ) );
-                }
-            }
+            continue;
+        }
+        const QString deviceNumber = QString::fromLatin1( fields[ 2 ] );
+        const QString source = unescapeProcField( fields[ separator + 2 ] );
+        if ( deviceNumbers.contains( deviceNumber ) || ( source.startsWith( '/' ) && isOneOf( source, devicePaths ) ) )
+        {
+            mountPoints.prepend( unescapeProcField( fields[ 4 ] ) );
         }
     }
-    else
+    return mountPoints;
+}
+
+/// @brief Reads a (one-line) sysfs attribute of block device @p name, e.g. "dev" or "dm/name"
+static QString
+sysBlockAttribute( const QString& name, const QString& attribute )
+{
+    QFile f( QStringLiteral( "/sys/class/block/%1/%2" ).arg( name, attribute ) );
+    if ( f.open( QIODevice::ReadOnly ) )
     {
-        cWarning() << "this system does not seem to have LVM2 tools.";
+        return QString::fromLocal8Bit( f.readAll() ).trimmed();
     }
+    return QString();
+}
 
-    const QStringList cryptoDevices2 = getCryptoDevices();
-    for ( const QString& mapperPath : cryptoDevices2 )
+/** @brief Appends the devices that are built on top of block device @p name
+ *
+ * Only device-mapper devices (LUKS, LVM) are followed; other holders,
+ * like MD RAID arrays, are left alone along with whatever is on them.
+ * Holders of holders come first, so @p devices is in the order in
+ * which things can be taken down.
+ */
+static void
+appendHolders( const QString& name, QStringList& devices )
+{
+    QDir holders( QStringLiteral( "/sys/class/block/%1/holders" ).arg( name ) );
+    for ( const QString& holder : holders.entryList( QDir::Dirs | QDir::NoDotAndDotDot ) )
     {
-        tryUmount( mapperPath );
-        QString news = tryCryptoClose( mapperPath );
-        if ( !news.isEmpty() )
+        const bool isDeviceMapper = QDir( QStringLiteral( "/sys/class/block/%1/dm" ).arg( holder ) ).exists();
+        if ( isDeviceMapper && !devices.contains( holder ) )
         {
-            goodNews.append( news );
+            appendHolders( holder, devices );
+            devices.append( holder );
         }
     }
+}
 
-    for ( const QString& p : partitionsList )
+/// @brief Removes device-mapper device @p name, like `dmsetup remove` does
+static bool
+removeMapperDevice( const QString& name )
+{
+    int fd = ::open( "/dev/mapper/control", O_RDWR | O_CLOEXEC );
+    if ( fd < 0 )
     {
-        QString partPath = QString( "/dev/%1" ).arg( p );
+        cWarning() << "Could not open device-mapper control device.";
+        return false;
+    }
 
-        QString news = tryUmount( partPath );
-        if ( !news.isEmpty() )
-        {
-            goodNews.append( news );
-        }
+    struct dm_ioctl io;
+    std::memset( &io, 0, sizeof( io ) );
+    // Version 4.0.0 is enough for DM_DEV_REMOVE, and accepted by every kernel
+    io.version[ 0 ] = DM_VERSION_MAJOR;
+    io.data_size = sizeof( io );
+    io.data_start = sizeof( io );
+    const QByteArray n = name.toLocal8Bit();
+    std::strncpy( io.name, n.constData(), DM_NAME_LEN - 1 );
+
+    const bool ok = ::ioctl( fd, DM_DEV_REMOVE, &io ) == 0;
+    if ( !ok )
+    {
+        cWarning() << "Could not remove device-mapper device" << name << std::strerror( errno );
     }
+    ::close( fd );
+    return ok;
+}
 
-    foreach ( QString p, swapPartitions )
+/** @brief Removes the hibernation signature from swap partition @p partPath
+ *
+ * A swap partition may contain something resumable from a previous
+ * suspend-to-disk; then its signature is replaced by a suspend signature
+ * (the original one is kept right before it). Put the original back,
+ * so that the kernel does not try to resume from it.
+ */
+static bool
+tryClearSwap( const QString& partPath )
+{
+    QFile f( partPath );
+    if ( !f.open( QIODevice::ReadWrite ) )
+    {
+        return false;
+    }
+    // The signature is at the end of the first page, but the page size varies
+    for ( qint64 pageSize : { 4096, 8192, 16384, 32768, 65536 } )
     {
-        QString news = tryClearSwap( p );
-        if ( !news.isEmpty() )
+        if ( !f.seek( pageSize - 20 ) )
+        {
+            break;
+        }
+        const QByteArray signatures = f.read( 20 );
+        if ( signatures.size() < 20 )
+        {
+            break;
+        }
+        const QByteArray sig = signatures.mid( 10 );
+        if ( sig.startsWith( "SWAPSPACE2" ) || sig.startsWith( "SWAP-SPACE" ) )
         {
-            goodNews.append( news );
+            return false;  // Regular swap, nothing to resume
+        }
+        if ( sig.startsWith( "S1SUSPEND" ) || sig.startsWith( "S2SUSPEND" ) || sig.startsWith( "ULSUSPEND" )
+             || sig.startsWith( "LINHIB0001" ) )
+        {
+            const QByteArray original = signatures.left( 10 );
+            const QByteArray restored = original.startsWith( "SWAP" ) ? original : QByteArray( "SWAPSPACE2" );
+            return f.seek( pageSize - 10 ) && f.write( restored ) == 10 && f.flush();
         }
     }
+    return false;
+}
 
-    Calamares::JobResult ok = Calamares::JobResult::ok();
-    ok.setMessage( tr( "Cleared all mounts for %1" ).arg( m_device->deviceNode() ) );
-    ok.setDetails( goodNews.join( "\n" ) );
+Calamares::JobResult
+ClearMountsJob::exec()
+{
+    CalamaresUtils::Partition::Syncer s;
 
-    cDebug() << "ClearMountsJob finished. Here's what was done:\n" << goodNews.join( "\n" );
+    QString deviceName = m_device->deviceNode().split( '/' ).last();
 
-    return ok;
-}
+    QStringList goodNews;
 
+    const QStringList partitionsList = getPartitionsForDevice( deviceName );
 
-QString
-ClearMountsJob::tryUmount( const QString& partPath )
-{
-    QProcess process;
-    process.start( "umount", { partPath } );
-    process.waitForFinished();
-    if ( process.exitCode() == 0 )
+    // Everything on this disk: device-mapper devices (LUKS, LVM) built
+    // on it, then the partitions, then the disk itself. This is the
+    // order in which they are taken down.
+    QStringList devices;
+    for ( const QString& name : partitionsList + QStringList { deviceName } )
     {
-        return QString( "Successfully unmounted %1." ).arg( partPath );
+        appendHolders( name, devices );
+        if ( !devices.contains( name ) )
+        {
+            devices.append( name );
+        }
     }
 
-    process.start( "swapoff", { partPath } );
-    process.waitForFinished();
-    if ( process.exitCode() == 0 )
+    QSet< QString > devicePaths;
+    QSet< QString > deviceNumbers;
+    for ( const QString& name : devices )
     {
-        return QString( "Successfully disabled swap %1." ).arg( partPath );
+        devicePaths.insert( QStringLiteral( "/dev/" ) + name );
+        const QString number = sysBlockAttribute( name, QStringLiteral( "dev" ) );
+        if ( !number.isEmpty() )
+        {
+            deviceNumbers.insert( number );
+        }
     }
+    cDebug() << "Clearing" << Logger::DebugList( devices );
 
-    return QString();
-}
+    // Swap first, since swap files live on filesystems that need unmounting
+    QFile swaps( "/proc/swaps" );
+    if ( swaps.open( QIODevice::ReadOnly ) )
+    {
+        const QList< QByteArray > lines = swaps.readAll().split( '\n' );
+        for ( const QByteArray& line : lines.mid( 1 ) )  // Skip the header
+        {
+            const QList< QByteArray > fields = line.simplified().split( ' ' );
+            if ( fields.count() < 2 )
+            {
+                continue;
+            }
+            const QString swapPath = unescapeProcField( fields[ 0 ] );
 
+            bool onDevice = false;
+            if ( fields[ 1 ] == "file" )
+            {
+                struct stat st;
+                onDevice = ::stat( swapPath.toLocal8Bit().constData(), &st ) == 0
+                    && deviceNumbers.contains(
+                        QStringLiteral( "%1:%2" ).arg( major( st.st_dev ) ).arg( minor( st.st_dev ) ) );
+            }
+            else
+            {
+                onDevice = isOneOf( swapPath, devicePaths );
+            }
 
-QString
-ClearMountsJob::tryClearSwap( const QString& partPath )
-{
-    QProcess process;
-    process.start( "blkid", { "-s", "UUID", "-o", "value", partPath } );
-    process.waitForFinished();
-    QString swapPartUuid = QString::fromLocal8Bit( process.readAllStandardOutput() ).simplified();
-    if ( process.exitCode() != 0 || swapPartUuid.isEmpty() )
-    {
-        return QString();
+            if ( onDevice )
+            {
+                if ( ::swapoff( swapPath.toLocal8Bit().constData() ) == 0 )
+                {
+                    goodNews.append( QString( "Successfully disabled swap %1." ).arg( swapPath ) );
+                }
+                else
+                {
+                    cWarning() << "Could not disable swap" << swapPath << std::strerror( errno );
+                }
+            }
+        }
     }
 
-    process.start( "mkswap", { "-U", swapPartUuid, partPath } );
-    process.waitForFinished();
-    if ( process.exitCode() != 0 )
+    QFile mountinfo( "/proc/self/mountinfo" );
+    if ( mountinfo.open( QIODevice::ReadOnly ) )
     {
-        return QString();
+        const QStringList mountPoints = getMountPointsForDevices( mountinfo.readAll(), devicePaths, deviceNumbers );
+        for ( const QString& mountPoint : mountPoints )
+        {
+            if ( ::umount2( mountPoint.toLocal8Bit().constData(), 0 ) == 0 )
+            {
+                goodNews.append( QString( "Successfully unmounted %1." ).arg( mountPoint ) );
+            }
+            else
+            {
+                cWarning() << "Could not unmount" << mountPoint << std::strerror( errno );
+            }
+        }
     }
-
-    return QString( "Successfully cleared swap %1." ).arg( partPath );
-}
-
-
-QString
-ClearMountsJob::tryCryptoClose( const QString& mapperPath )
-{
-    QProcess process;
-    process.start( "cryptsetup", { "close", mapperPath } );
-    process.waitForFinished();
-    if ( process.exitCode() == 0 )
+    else
     {
-        return QString( "Successfully closed mapper device %1." ).arg( mapperPath );
+        cWarning() << "Could not open" << mountinfo.fileName();
     }
 
-    return QString();
-}
-
-
-QStringList
-ClearMountsJob::getCryptoDevices() const
-{
-    QDir mapperDir( "/dev/mapper" );
-    const QFileInfoList fiList = mapperDir.entryInfoList( QDir::Files );
-    QStringList list;
-    QProcess process;
-    for ( const QFileInfo& fi : fiList )
+    // Close LUKS devices and deactivate LVM logical volumes, top-down
+    for ( const QString& name : devices )
     {
-        QString baseName = fi.baseName();
+        const QString mapperName = sysBlockAttribute( name, QStringLiteral( "dm/name" ) );
         // Fedora live images use /dev/mapper/live-* internally. We must not
         // unmount those devices, because they are used by the live image and
         // because we need /dev/mapper/live-base in the unpackfs module.
-        if ( baseName == "control" || baseName.startsWith( "live-" ) )
+        if ( mapperName.isEmpty() || mapperName.startsWith( "live-" ) )
         {
             continue;
         }
-        list.append( fi.absoluteFilePath() );
+        const bool isLVM = sysBlockAttribute( name, QStringLiteral( "dm/uuid" ) ).startsWith( "LVM-" );
+        if ( removeMapperDevice( mapperName ) )
+        {
+            goodNews.append( isLVM ? QString( "Successfully disabled logical volume %1." ).arg( mapperName )
+                                   : QString( "Successfully closed mapper device %1." ).arg( mapperName ) );
+        }
+    }
+
+    for ( const QString& p : partitionsList )
+    {
+        const QString partPath = QStringLiteral( "/dev/" ) + p;
+        if ( tryClearSwap( partPath ) )
+        {
+            goodNews.append( QString( "Successfully cleared swap %1." ).arg( partPath ) );
+        }
     }
-    return list;
+
+    Calamares::JobResult ok = Calamares::JobResult::ok();
+    ok.setMessage( tr( "Cleared all mounts for %1" ).arg( m_device->deviceNode() ) );
+    ok.setDetails( goodNews.join( "\n" ) );
+
+    cDebug() << "ClearMountsJob finished. Here's what was done:\n" << goodNews.join( "\n" );
+
+    return ok;
 }
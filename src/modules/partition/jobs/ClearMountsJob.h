@@ -25,7 +25,9 @@ class Device;
 
 /**
  * This job tries to free all mounts for the given device, so partitioning
- * operations can proceed.
+ * operations can proceed. Swap is turned off, filesystems are unmounted and
+ * LUKS and LVM devices on top of the device are closed, without running
+ * external tools; the kernel (/proc and /sys) says what is in use.
  */
 class ClearMountsJob : public Calamares::Job
 {
@@ -37,10 +39,6 @@ public:
     Calamares::JobResult exec() override;
 
 private:
-    QString tryUmount( const QString& partPath );
-    QString tryClearSwap( const QString& partPath );
-    QString tryCryptoClose( const QString& mapperPath );
-    QStringList getCryptoDevices() const;
     Device* m_device;
 };
 
@@ -0,0 +1,127 @@
+/* === This file is part of Calamares - <https://github.com/calamares> ===
+ *
+ *   Copyright 2020, agent <agent@local>
+ *
+ *   Calamares is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Calamares is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Calamares. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DiscardDeviceJob.h"
+
+#include "utils/Logger.h"
+#include "utils/NamedEnum.h"
+
+// KPMcore
+#include <kpmcore/core/device.h>
+
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+/// Discard (or zero) this much at a time, so that there is progress to report
+static constexpr uint64_t s_chunkSize = uint64_t( 1 ) << 30;  // 1GiB
+
+DiscardDeviceJob::DiscardDeviceJob( Device* device, Mode mode )
+    : Calamares::Job()
+    , m_device( device )
+    , m_mode( mode )
+{
+}
+
+
+QString
+DiscardDeviceJob::prettyName() const
+{
+    return tr( "Discard all data on %1." ).arg( m_device->deviceNode() );
+}
+
+
+QString
+DiscardDeviceJob::prettyDescription() const
+{
+    return tr( "Discard all data on <strong>%1</strong> (%2)." ).arg( m_device->deviceNode() ).arg( m_device->name() );
+}
+
+
+QString
+DiscardDeviceJob::prettyStatusMessage() const
+{
+    return tr( "Discarding all data on %1." ).arg( m_device->deviceNode() );
+}
+
+
+Calamares::JobResult
+DiscardDeviceJob::exec()
+{
+    // None of the problems here are errors: the device just keeps its old
+    // data around, which the new partition table makes unreachable anyway.
+    const QString path = m_device->deviceNode();
+    int fd = ::open( path.toLocal8Bit().constData(), O_WRONLY | O_CLOEXEC );
+    if ( fd < 0 )
+    {
+        cWarning() << "Could not open" << path << "to discard:" << std::strerror( errno );
+        return Calamares::JobResult::ok();
+    }
+
+    uint64_t size = 0;
+    if ( ::ioctl( fd, BLKGETSIZE64, &size ) != 0 )
+    {
+        cWarning() << "Could not get the size of" << path << std::strerror( errno );
+        size = 0;
+    }
+
+    unsigned long request = BLKDISCARD;
+    uint64_t offset = 0;
+    while ( offset < size )
+    {
+        uint64_t range[ 2 ] = { offset, std::min( s_chunkSize, size - offset ) };
+        if ( ::ioctl( fd, request, range ) != 0 )
+        {
+            if ( errno == EOPNOTSUPP && request == BLKDISCARD && m_mode == Mode::DiscardOrZero )
+            {
+                cDebug() << path << "does not support discard, zeroing it instead.";
+                request = BLKZEROOUT;
+                continue;
+            }
+            cWarning() << "Could not" << ( request == BLKDISCARD ? "discard" : "zero" ) << path << "at" << offset
+                       << std::strerror( errno );
+            break;
+        }
+        offset += range[ 1 ];
+        emit progress( qreal( offset ) / qreal( size ) );
+    }
+    ::close( fd );
+
+    if ( size > 0 && offset == size )
+    {
+        cDebug() << ( request == BLKDISCARD ? "Discarded" : "Zeroed" ) << size << "bytes on" << path;
+    }
+    return Calamares::JobResult::ok();
+}
+
+
+DiscardDeviceJob::Mode
+DiscardDeviceJob::nameToMode( const QString& name, bool& ok )
+{
+    static const NamedEnumTable< Mode > names { { QStringLiteral( "none" ), Mode::None },
+                                                { QStringLiteral( "discard" ), Mode::Discard },
+                                                { QStringLiteral( "zero" ), Mode::DiscardOrZero } };
+
+    return names.find( name, ok );
+}
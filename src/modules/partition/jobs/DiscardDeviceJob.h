@@ -0,0 +1,60 @@
+/* === This file is part of Calamares - <https://github.com/calamares> ===
+ *
+ *   Copyright 2020, agent <agent@local>
+ *
+ *   Calamares is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Calamares is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Calamares. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DISCARDDEVICEJOB_H
+#define DISCARDDEVICEJOB_H
+
+#include "Job.h"
+
+class Device;
+
+/**
+ * Discards all the data on a device, before a new partition table is
+ * created on it. This tells SSDs and thin-provisioned storage that all
+ * blocks are unused, so later writes (and mkfs) are faster.
+ *
+ * If the device does not support discard, it can be zeroed instead,
+ * which is slow unless the device can do that by itself. A device that
+ * can't be discarded is not an error: the job does nothing then.
+ */
+class DiscardDeviceJob : public Calamares::Job
+{
+    Q_OBJECT
+public:
+    enum class Mode
+    {
+        None,  ///< Don't discard (no job is created)
+        Discard,  ///< Discard, if the device supports it
+        DiscardOrZero  ///< Discard, or zero the device if it can't discard
+    };
+
+    DiscardDeviceJob( Device* device, Mode mode );
+    QString prettyName() const override;
+    QString prettyDescription() const override;
+    QString prettyStatusMessage() const override;
+    Calamares::JobResult exec() override;
+
+    /// @brief The mode for a name in partition.conf ("none", "discard", "zero")
+    static Mode nameToMode( const QString& name, bool& ok );
+
+private:
+    Device* m_device;
+    Mode m_mode;
+};
+
+#endif /* DISCARDDEVICEJOB_H */
@@ -0,0 +1,173 @@
+/* === This file is part of Calamares - <https://github.com/calamares> ===
+ *
+ *   Copyright 2020, agent <agent@local>
+ *
+ *   Calamares is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Calamares is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Calamares. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ParallelDevicesJob.h"
+
+#include "utils/Logger.h"
+
+#include <QFuture>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+
+ParallelDevicesJob::ParallelDevicesJob( const QList< Calamares::JobList >& jobLists )
+    : Calamares::Job()
+    , m_jobLists( jobLists )
+    , m_progress( jobLists.count(), 0.0 )
+{
+    for ( const auto& jobs : m_jobLists )
+    {
+        for ( const auto& job : jobs )
+        {
+            m_totalWeight += job->getJobWeight();
+        }
+    }
+}
+
+
+qreal
+ParallelDevicesJob::getJobWeight() const
+{
+    // Weigh the same as the jobs would, one after the other
+    return m_totalWeight;
+}
+
+
+QString
+ParallelDevicesJob::prettyName() const
+{
+    return tr( "Partition %n device(s) at the same time.", "", m_jobLists.count() );
+}
+
+
+QString
+ParallelDevicesJob::prettyDescription() const
+{
+    // The summary page lists the descriptions of the individual jobs
+    QStringList descriptions;
+    for ( const auto& jobs : m_jobLists )
+    {
+        for ( const auto& job : jobs )
+        {
+            if ( !job->prettyDescription().isEmpty() )
+            {
+                descriptions.append( job->prettyDescription() );
+            }
+        }
+    }
+    return descriptions.join( QStringLiteral( "<br/>" ) );
+}
+
+
+QString
+ParallelDevicesJob::prettyStatusMessage() const
+{
+    QMutexLocker lock( &m_mutex );
+    return m_status.isEmpty() ? prettyName() : m_status;
+}
+
+
+void
+ParallelDevicesJob::updateProgress( int index, qreal done )
+{
+    qreal total = 0.0;
+    {
+        QMutexLocker lock( &m_mutex );
+        m_progress[ index ] = done;
+        for ( qreal p : m_progress )
+        {
+            total += p;
+        }
+    }
+    if ( m_totalWeight > 0.0 )
+    {
+        emit progress( total / m_totalWeight );
+    }
+}
+
+
+ParallelDevicesJob::Failure
+ParallelDevicesJob::runList( int index )
+{
+    qreal done = 0.0;
+    for ( const auto& job : m_jobLists.at( index ) )
+    {
+        {
+            QMutexLocker lock( &m_mutex );
+            if ( m_failed )
+            {
+                cDebug() << "Skipping job" << job->prettyName();
+                return {};
+            }
+            m_status = job->prettyStatusMessage();
+        }
+
+        cDebug() << "Starting job" << job->prettyName() << "for device" << index;
+        const qreal weight = job->getJobWeight();
+        auto connection = connect(
+            job.data(),
+            &Calamares::Job::progress,
+            this,
+            [ this, index, done, weight ]( qreal percent ) {
+                updateProgress( index, done + weight * qBound( qreal( 0 ), percent, qreal( 1 ) ) );
+            },
+            Qt::DirectConnection );
+        Calamares::JobResult result = job->exec();
+        disconnect( connection );
+
+        done += weight;
+        updateProgress( index, done );
+        if ( !result )
+        {
+            QMutexLocker lock( &m_mutex );
+            m_failed = true;
+            return Failure { true, result.message(), result.details() };
+        }
+    }
+    return {};
+}
+
+
+Calamares::JobResult
+ParallelDevicesJob::exec()
+{
+    // A pool of our own, so that all the devices get a thread right away
+    QThreadPool pool;
+    pool.setMaxThreadCount( qMax( 1, m_jobLists.count() ) );
+
+    QList< QFuture< Failure > > results;
+    for ( int i = 0; i < m_jobLists.count(); ++i )
+    {
+        results.append( QtConcurrent::run( &pool, [ this, i ]() { return runList( i ); } ) );
+    }
+
+    for ( auto& result : results )
+    {
+        result.waitForFinished();
+    }
+    for ( const auto& result : results )
+    {
+        const Failure failure = result.result();
+        if ( failure.failed )
+        {
+            return Calamares::JobResult::error( failure.message, failure.details );
+        }
+    }
+    return Calamares::JobResult::ok();
+}
@@ -0,0 +1,72 @@
+/* === This file is part of Calamares - <https://github.com/calamares> ===
+ *
+ *   Copyright 2020, agent <agent@local>
+ *
+ *   Calamares is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Calamares is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Calamares. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PARALLELDEVICESJOB_H
+#define PARALLELDEVICESJOB_H
+
+#include "Job.h"
+
+#include <QList>
+#include <QMutex>
+#include <QVector>
+
+/** @brief Runs the jobs for several (independent) devices at the same time
+ *
+ * Each list of jobs is run in order, in a thread of its own, so
+ * a slow job (e.g. formatting a large disk) on one device does not
+ * hold up the jobs on the others. Once a job fails, no more jobs
+ * are started, but jobs that are already running are not stopped.
+ * The result is that of the first list (in order) that failed.
+ *
+ * The jobs in different lists must not depend on each other.
+ */
+class ParallelDevicesJob : public Calamares::Job
+{
+    Q_OBJECT
+public:
+    explicit ParallelDevicesJob( const QList< Calamares::JobList >& jobLists );
+
+    qreal getJobWeight() const override;
+    QString prettyName() const override;
+    QString prettyDescription() const override;
+    QString prettyStatusMessage() const override;
+    Calamares::JobResult exec() override;
+
+private:
+    struct Failure
+    {
+        bool failed = false;
+        QString message;
+        QString details;
+    };
+
+    /// @brief Runs the jobs in list @p index, returns the failure (if any)
+    Failure runList( int index );
+    /// @brief Sets the weight @p done of list @p index and emits progress
+    void updateProgress( int index, qreal done );
+
+    QList< Calamares::JobList > m_jobLists;
+    qreal m_totalWeight = 0.0;
+
+    mutable QMutex m_mutex;
+    QVector< qreal > m_progress;  ///< Weight done, per list
+    QString m_status;
+    bool m_failed = false;
+};
+
+#endif  // PARALLELDEVICESJOB_H
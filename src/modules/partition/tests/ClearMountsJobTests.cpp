@@ -28,6 +28,10 @@ QTEST_GUILESS_MAIN( ClearMountsJobTests )
 /* Not exactly public API */
 QStringList
 getPartitionsForDevice( const QString& deviceName );
+QStringList
+getMountPointsForDevices( const QByteArray& mountinfo,
+                          const QSet< QString >& devicePaths,
+                          const QSet< QString >& deviceNumbers );
 
 QStringList
 getPartitionsForDevice_other(const QString& deviceName)
@@ -68,3 +72,21 @@ void ClearMountsJobTests::testFindPartitions()
 
     QCOMPARE( partitions, other_part );
 }
+
+void ClearMountsJobTests::testMountPoints()
+{
+    const QByteArray mountinfo(
+        "22 1 8:2 / / rw,relatime shared:1 - ext4 /dev/sda2 rw\n"
+        "23 22 0:21 / /proc rw,nosuid shared:2 - proc proc rw\n"
+        "40 22 8:17 / /mnt/my\\040disk rw,relatime shared:20 - ext4 /dev/sdb1 rw\n"
+        "41 40 0:45 / /mnt/my\\040disk/home rw,relatime shared:21 - btrfs /dev/sdb2 rw,subvol=/home\n"
+        "42 22 8:18 / /mnt/other rw,relatime shared:22 - vfat /dev/sdb3 rw\n" );
+
+    // By device number, and by source for btrfs (which has its own device numbers)
+    QCOMPARE( getMountPointsForDevices( mountinfo, { "/dev/sdb1", "/dev/sdb2" }, { "8:17" } ),
+              QStringList( { "/mnt/my disk/home", "/mnt/my disk" } ) );
+    QCOMPARE( getMountPointsForDevices( mountinfo, {}, { "8:2", "8:18" } ),
+              QStringList( { "/mnt/other", "/" } ) );
+    QCOMPARE( getMountPointsForDevices( mountinfo, { "/dev/sdc1" }, { "8:33" } ), QStringList() );
+    QCOMPARE( getMountPointsForDevices( QByteArray(), { "/dev/sda2" }, { "8:2" } ), QStringList() );
+}
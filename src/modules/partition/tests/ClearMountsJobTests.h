@@ -29,6 +29,7 @@ public:
 
 private Q_SLOTS:
     void testFindPartitions();
+    void testMountPoints();
 };
 
 #endif
@@ -0,0 +1,143 @@
+/* === This file is part of Calamares - <https://github.com/calamares> ===
+ *
+ *   Copyright 2020, agent <agent@local>
+ *
+ *   Calamares is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Calamares is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Calamares. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ParallelDevicesJobTests.h"
+
+#include "jobs/ParallelDevicesJob.h"
+
+#include "utils/Logger.h"
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSemaphore>
+#include <QtTest/QtTest>
+
+QTEST_GUILESS_MAIN( ParallelDevicesJobTests )
+
+/// @brief Signals @p mine and waits (a while) for @p theirs
+class RendezvousJob : public Calamares::Job
+{
+public:
+    RendezvousJob( QSemaphore& mine, QSemaphore& theirs )
+        : m_mine( mine )
+        , m_theirs( theirs )
+    {
+    }
+
+    QString prettyName() const override { return QStringLiteral( "Rendezvous" ); }
+    Calamares::JobResult exec() override
+    {
+        m_mine.release();
+        if ( m_theirs.tryAcquire( 1, 5000 ) )
+        {
+            return Calamares::JobResult::ok();
+        }
+        return Calamares::JobResult::error( QStringLiteral( "Alone" ) );
+    }
+
+private:
+    QSemaphore& m_mine;
+    QSemaphore& m_theirs;
+};
+
+/// @brief Counts how often it runs, and fails if @p fail is set
+class CountingJob : public Calamares::Job
+{
+public:
+    CountingJob( QAtomicInt& count, bool fail = false )
+        : m_count( count )
+        , m_fail( fail )
+    {
+    }
+
+    QString prettyName() const override { return QStringLiteral( "Count" ); }
+    QString prettyDescription() const override { return QStringLiteral( "Count %1" ).arg( m_fail ? 1 : 0 ); }
+    Calamares::JobResult exec() override
+    {
+        m_count.ref();
+        if ( m_fail )
+        {
+            return Calamares::JobResult::error( QStringLiteral( "Failed" ), QStringLiteral( "On purpose" ) );
+        }
+        return Calamares::JobResult::ok();
+    }
+
+private:
+    QAtomicInt& m_count;
+    bool m_fail;
+};
+
+ParallelDevicesJobTests::ParallelDevicesJobTests()
+{
+    Logger::setupLogLevel( Logger::LOGDEBUG );
+}
+
+void
+ParallelDevicesJobTests::testConcurrent()
+{
+    // Each job waits for the other, so this only works if they run at the same time
+    QSemaphore a;
+    QSemaphore b;
+    ParallelDevicesJob job( { { Calamares::job_ptr( new RendezvousJob( a, b ) ) },
+                              { Calamares::job_ptr( new RendezvousJob( b, a ) ) } } );
+    QCOMPARE( job.getJobWeight(), 2.0 );
+
+    // Progress is reported from both threads, in any order
+    QMutex progressMutex;
+    QList< qreal > progress;
+    connect( &job, &Calamares::Job::progress, [ &progressMutex, &progress ]( qreal p ) {
+        QMutexLocker lock( &progressMutex );
+        progress.append( p );
+    } );
+    auto result = job.exec();
+    QVERIFY( result );
+    QCOMPARE( progress.count(), 2 );
+    QVERIFY( progress.contains( 1.0 ) );
+}
+
+void
+ParallelDevicesJobTests::testFailure()
+{
+    QAtomicInt count;
+    ParallelDevicesJob job( { { Calamares::job_ptr( new CountingJob( count, true ) ),
+                                Calamares::job_ptr( new CountingJob( count ) ) } } );
+    auto result = job.exec();
+    QVERIFY( !result );
+    QCOMPARE( result.message(), QStringLiteral( "Failed" ) );
+    QCOMPARE( result.details(), QStringLiteral( "On purpose" ) );
+    // The job after the failed one does not run
+    QCOMPARE( count.load(), 1 );
+
+    QAtomicInt otherCount;
+    ParallelDevicesJob okJob( { { Calamares::job_ptr( new CountingJob( otherCount ) ) },
+                                { Calamares::job_ptr( new CountingJob( otherCount ) ),
+                                  Calamares::job_ptr( new CountingJob( otherCount ) ) } } );
+    QVERIFY( okJob.exec() );
+    QCOMPARE( otherCount.load(), 3 );
+}
+
+void
+ParallelDevicesJobTests::testDescription()
+{
+    QAtomicInt count;
+    ParallelDevicesJob job( { { Calamares::job_ptr( new CountingJob( count ) ) },
+                              { Calamares::job_ptr( new CountingJob( count, true ) ) } } );
+    QCOMPARE( job.prettyDescription(), QStringLiteral( "Count 0<br/>Count 1" ) );
+    QCOMPARE( count.load(), 0 );
+}
@@ -0,0 +1,36 @@
+/* === This file is part of Calamares - <https://github.com/calamares> ===
+ *
+ *   Copyright 2020, agent <agent@local>
+ *
+ *   Calamares is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Calamares is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Calamares. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PARALLELDEVICESJOBTESTS_H
+#define PARALLELDEVICESJOBTESTS_H
+
+#include <QObject>
+
+class ParallelDevicesJobTests : public QObject
+{
+    Q_OBJECT
+public:
+    ParallelDevicesJobTests();
+
+private Q_SLOTS:
+    void testConcurrent();
+    void testFailure();
+    void testDescription();
+};
+
+#endif
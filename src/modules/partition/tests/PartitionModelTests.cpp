@@ -0,0 +1,279 @@
+/* === This file is part of Calamares - <https://github.com/calamares> ===
+ *
+ *   Copyright 2020, agent <agent@local>
+ *
+ *   Calamares is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Calamares is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Calamares. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PartitionModelTests.h"
+
+#include "core/KPMHelpers.h"
+#include "core/PartitionModel.h"
+
+#include "utils/Logger.h"
+
+// KPMcore
+#include <kpmcore/core/diskdevice.h>
+#include <kpmcore/core/partition.h>
+#include <kpmcore/core/partitionrole.h>
+#include <kpmcore/core/partitiontable.h>
+#include <kpmcore/fs/filesystemfactory.h>
+#include <kpmcore/fs/luks.h>
+
+#include <QPersistentModelIndex>
+#include <QSignalSpy>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtTest/QtTest>
+
+QTEST_GUILESS_MAIN( PartitionModelTests )
+
+/// @brief Does the model have the same rows (under @p parent) as @p node has children?
+static bool
+matchesDevice( const PartitionModel& model, const QModelIndex& parent, PartitionNode* node )
+{
+    const auto children = node->children();
+    if ( model.rowCount( parent ) != children.count() )
+    {
+        return false;
+    }
+    for ( int i = 0; i < children.count(); ++i )
+    {
+        const QModelIndex index = model.index( i, 0, parent );
+        if ( model.partitionForIndex( index ) != children.at( i )
+             || !matchesDevice( model, index, children.at( i ) ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief Adds a new ext4 partition from @p first to @p last to the table of @p device
+static Partition*
+addPartition( Device& device, qint64 first, qint64 last )
+{
+    PartitionTable* table = device.partitionTable();
+    Partition* partition = KPMHelpers::createNewPartition( table,
+                                                           device,
+                                                           PartitionRole( PartitionRole::Primary ),
+                                                           FileSystem::Ext4,
+                                                           first,
+                                                           last,
+                                                           KPM_PARTITION_FLAG( None ) );
+    table->removeUnallocated();
+    table->insert( partition );
+    table->updateUnallocated( device );
+    return partition;
+}
+
+PartitionModelTests::PartitionModelTests() {}
+
+void
+PartitionModelTests::initTestCase()
+{
+    Logger::setupLogLevel( Logger::LOGDEBUG );
+    FileSystemFactory::init();
+}
+
+void
+PartitionModelTests::testRowSignals()
+{
+    // 255 * 63 * 1000 sectors of 512 bytes is about 7.6GiB
+    DiskDevice device( QStringLiteral( "Test" ), QStringLiteral( "/dev/calamares-test" ), 255, 63, 1000, 512 );
+    PartitionTable* table = new PartitionTable( PartitionTable::msdos, 2048, device.totalLogical() - 1 );
+    device.setPartitionTable( table );
+    table->updateUnallocated( device );
+
+    Partition* first = addPartition( device, 2048, 204799 );
+    Partition* second = addPartition( device, 204800, 409599 );
+    Partition* third = addPartition( device, 409600, 614399 );
+
+    PartitionModel model;
+    model.init( &device, OsproberEntryList() );
+    QVERIFY( matchesDevice( model, QModelIndex(), table ) );
+    QCOMPARE( model.rowCount(), 4 );  // And the free space at the end
+
+    // Replays the row signals on a list of the rows, to check the
+    // signals against the device afterwards.
+    QVector< Partition* > rows;
+    for ( int i = 0; i < model.rowCount(); ++i )
+    {
+        rows.append( model.partitionForIndex( model.index( i, 0 ) ) );
+    }
+    connect( &model, &QAbstractItemModel::rowsAboutToBeRemoved, [ &rows ]( const QModelIndex& parent, int f, int l ) {
+        QVERIFY( !parent.isValid() );
+        rows.remove( f, l - f + 1 );
+    } );
+    connect( &model,
+             &QAbstractItemModel::rowsInserted,
+             [ &rows, &model ]( const QModelIndex& parent, int f, int l ) {
+                 QVERIFY( !parent.isValid() );
+                 for ( int i = f; i <= l; ++i )
+                 {
+                     rows.insert( i, model.partitionForIndex( model.index( i, 0 ) ) );
+                 }
+             } );
+    QSignalSpy reset( &model, SIGNAL( modelReset() ) );
+    QSignalSpy removed( &model, SIGNAL( rowsRemoved( QModelIndex, int, int ) ) );
+    QSignalSpy inserted( &model, SIGNAL( rowsInserted( QModelIndex, int, int ) ) );
+
+    // Rows that stay keep their place, without a reset
+    QPersistentModelIndex firstIndex( model.index( 0, 0 ) );
+    QPersistentModelIndex thirdIndex( model.index( 2, 0 ) );
+
+    // Delete the partition in the middle, which leaves free space behind
+    {
+        PartitionModel::UpdateHelper helper( &model );
+        table->remove( second );
+        table->updateUnallocated( device );
+    }
+    delete second;
+    QCOMPARE( reset.count(), 0 );
+    QVERIFY( removed.count() > 0 );
+    QCOMPARE( rows.toList(), table->children() );
+    QVERIFY( matchesDevice( model, QModelIndex(), table ) );
+    QCOMPARE( model.partitionForIndex( firstIndex ), first );
+    QCOMPARE( model.partitionForIndex( thirdIndex ), third );
+    QCOMPARE( thirdIndex.row(), 2 );
+
+    // Create a partition in that free space again
+    removed.clear();
+    inserted.clear();
+    Partition* fourth = nullptr;
+    {
+        PartitionModel::UpdateHelper helper( &model );
+        fourth = addPartition( device, 204800, 409599 );
+    }
+    QCOMPARE( reset.count(), 0 );
+    QVERIFY( inserted.count() > 0 );
+    QCOMPARE( rows.toList(), table->children() );
+    QVERIFY( matchesDevice( model, QModelIndex(), table ) );
+    QCOMPARE( model.partitionForIndex( model.index( 1, 0 ) ), fourth );
+    QCOMPARE( model.partitionForIndex( firstIndex ), first );
+    QCOMPARE( model.partitionForIndex( thirdIndex ), third );
+
+    // Nothing changes, nothing is said
+    removed.clear();
+    inserted.clear();
+    {
+        PartitionModel::UpdateHelper helper( &model );
+    }
+    QCOMPARE( removed.count(), 0 );
+    QCOMPARE( inserted.count(), 0 );
+}
+
+void
+PartitionModelTests::testOtherThread()
+{
+    DiskDevice device( QStringLiteral( "Test" ), QStringLiteral( "/dev/calamares-test" ), 255, 63, 1000, 512 );
+    PartitionTable* table = new PartitionTable( PartitionTable::msdos, 2048, device.totalLogical() - 1 );
+    device.setPartitionTable( table );
+    table->updateUnallocated( device );
+
+    addPartition( device, 2048, 204799 );
+    Partition* second = addPartition( device, 204800, 409599 );
+
+    PartitionModel model;
+    model.init( &device, OsproberEntryList() );
+    QVERIFY( matchesDevice( model, QModelIndex(), table ) );
+
+    QSignalSpy reset( &model, SIGNAL( modelReset() ) );
+    QSignalSpy removed( &model, SIGNAL( rowsRemoved( QModelIndex, int, int ) ) );
+    QSignalSpy inserted( &model, SIGNAL( rowsInserted( QModelIndex, int, int ) ) );
+
+    // Like the Replace and Alongside choices do, change the device from a
+    // worker thread; the views only hear (queued) about a reset then.
+    auto future = QtConcurrent::run( [ & ]() {
+        PartitionModel::UpdateHelper helper( &model, second );
+        {
+            PartitionModel::UpdateHelper nested( &model );
+            table->remove( second );
+            table->updateUnallocated( device );
+        }
+        delete second;
+        addPartition( device, 204800, 309599 );
+    } );
+    future.waitForFinished();
+
+    QCOMPARE( reset.count(), 1 );
+    QCOMPARE( removed.count(), 0 );
+    QCOMPARE( inserted.count(), 0 );
+    QVERIFY( matchesDevice( model, QModelIndex(), table ) );
+
+    // Back on the model's thread, there are row signals again
+    reset.clear();
+    {
+        PartitionModel::UpdateHelper helper( &model );
+        addPartition( device, 309600, 409599 );
+    }
+    QCOMPARE( reset.count(), 0 );
+    QVERIFY( inserted.count() > 0 );
+    QVERIFY( matchesDevice( model, QModelIndex(), table ) );
+}
+
+void
+PartitionModelTests::testRevertDevice()
+{
+    DiskDevice device( QStringLiteral( "Test" ), QStringLiteral( "/dev/calamares-test" ), 255, 63, 1000, 512 );
+    PartitionTable* table = new PartitionTable( PartitionTable::msdos, 2048, device.totalLogical() - 1 );
+    device.setPartitionTable( table );
+    table->updateUnallocated( device );
+    addPartition( device, 2048, 204799 );
+    addPartition( device, 204800, 409599 );
+
+    // The scanned state, as PartitionCoreModule keeps it
+    const PartitionTable original( *table );
+
+    // Change the device, then revert it
+    {
+        Partition* gone = table->children().at( 1 );
+        table->remove( gone );
+        delete gone;
+        table->updateUnallocated( device );
+    }
+    QCOMPARE( table->children().count(), 2 );
+    QVERIFY( KPMHelpers::restorePartitionTable( &device, &original ) );
+    QVERIFY( device.partitionTable() != &original );
+    QCOMPARE( device.partitionTable()->children().count(), original.children().count() );
+    for ( int i = 0; i < original.children().count(); ++i )
+    {
+        const Partition* restored = device.partitionTable()->children().at( i );
+        const Partition* scanned = original.children().at( i );
+        QCOMPARE( restored->firstSector(), scanned->firstSector() );
+        QCOMPARE( restored->lastSector(), scanned->lastSector() );
+        QCOMPARE( restored->fileSystem().type(), scanned->fileSystem().type() );
+    }
+
+    // A copy would lose the inner filesystem of the encrypted partition,
+    // so a device with one is not restored from the copy (but rescanned).
+    table = device.partitionTable();
+    table->removeUnallocated();
+    Partition* encrypted = KPMHelpers::createNewEncryptedPartition( table,
+                                                                     device,
+                                                                     PartitionRole( PartitionRole::Primary ),
+                                                                     FileSystem::Ext4,
+                                                                     409600,
+                                                                     614399,
+                                                                     QStringLiteral( "secret" ),
+                                                                     KPM_PARTITION_FLAG( None ) );
+    QVERIFY( encrypted );
+    table->insert( encrypted );
+    table->updateUnallocated( device );
+    QVERIFY( dynamic_cast< const FS::luks& >( encrypted->fileSystem() ).innerFS() );
+
+    const PartitionTable encryptedOriginal( *table );
+    QVERIFY( !KPMHelpers::restorePartitionTable( &device, &encryptedOriginal ) );
+    QCOMPARE( device.partitionTable(), table );
+    QVERIFY( table->children().contains( encrypted ) );
+}
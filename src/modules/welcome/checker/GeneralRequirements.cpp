@@ -275,29 +275,52 @@ GeneralRequirements::setConfigurationMap( const QVariantMap& configurationMap )
         incompleteConfiguration = true;
     }
 
-    QUrl checkInternetUrl;
-    QString checkInternetSetting = CalamaresUtils::getString( configurationMap, "internetCheckUrl" );
-    if ( !checkInternetSetting.isEmpty() )
+    QVector< QUrl > checkInternetUrls;
+    const QVariant checkInternetSetting = configurationMap.value( "internetCheckUrl" );
+    const QStringList checkInternetStrings = checkInternetSetting.type() == QVariant::List
+        ? checkInternetSetting.toStringList()
+        : QStringList { checkInternetSetting.toString() };
+    for ( const auto& s : checkInternetStrings )
     {
-        checkInternetUrl = QUrl( checkInternetSetting.trimmed() );
-        if ( !checkInternetUrl.isValid() )
+        if ( s.trimmed().isEmpty() )
         {
-            cWarning() << "GeneralRequirements entry 'internetCheckUrl' is invalid in welcome.conf"
-                       << checkInternetSetting << "reverting to default (http://example.com).";
-            checkInternetUrl = QUrl( "http://example.com" );
+            continue;
+        }
+        QUrl checkInternetUrl( s.trimmed() );
+        if ( checkInternetUrl.isValid() )
+        {
+            checkInternetUrls.append( checkInternetUrl );
+        }
+        else
+        {
+            cWarning() << "GeneralRequirements entry 'internetCheckUrl' is invalid in welcome.conf" << s;
             incompleteConfiguration = true;
         }
     }
-    else
+    if ( checkInternetUrls.isEmpty() )
     {
         cWarning() << "GeneralRequirements entry 'internetCheckUrl' is undefined in welcome.conf,"
                       "reverting to default (http://example.com).";
-        checkInternetUrl = "http://example.com";
+        checkInternetUrls.append( QUrl( "http://example.com" ) );
         incompleteConfiguration = true;
     }
-    if ( checkInternetUrl.isValid() )
+    auto& nam = CalamaresUtils::Network::Manager::instance();
+    nam.setCheckHasInternetUrl( checkInternetUrls );
+    const qint64 checkInternetTtl = CalamaresUtils::getInteger( configurationMap, "internetCheckTtl", 30 );
+    if ( checkInternetTtl >= 0 )
+    {
+        nam.setCheckHasInternetTtl( std::chrono::seconds( checkInternetTtl ) );
+    }
+    else
+    {
+        cWarning() << "GeneralRequirements entry 'internetCheckTtl' is negative in welcome.conf" << checkInternetTtl;
+        incompleteConfiguration = true;
+    }
+    if ( m_entriesToCheck.contains( "internet" ) )
     {
-        CalamaresUtils::Network::Manager::instance().setCheckHasInternetUrl( checkInternetUrl );
+        // Start checking now, so that the requirements-check
+        // can use the result instead of pinging itself.
+        nam.asynchronousCheckHasInternet();
     }
 
     if ( incompleteConfiguration )